@@ -2,3 +2,9 @@
 find_package(PythonLibs REQUIRED)
 message("CMAKE_SOURCE_DIR : ${CMAKE_SOURCE_DIR}")
 include_directories(${PYTHON_INCLUDE_DIR})
+# the batched methods distribute their work over std::threads
+find_package(Threads REQUIRED)
+# compile the instrumentation counters of the solvers into the module, see instrumentation.hh
+option(DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION "collect evaluation counts and timings in the analytic solvers" OFF)
+# record timeline spans of the multi-threaded methods, see tracing.hh
+option(DUNEURO_ANALYTIC_SOLUTION_TRACING "record Chrome traces of the multi-threaded analytic solvers" OFF)
@@ -40,6 +40,12 @@
 /* Define to the revision of duneuro-analytic-solution */
 #define DUNEURO_ANALYTIC_SOLUTION_VERSION_REVISION @DUNEURO_ANALYTIC_SOLUTION_VERSION_REVISION@
 
+/* Define to 1 to let the analytic solvers collect evaluation counts and timings */
+#cmakedefine01 DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION
+
+/* Define to 1 to let the multi-threaded methods record spans for Chrome traces */
+#cmakedefine01 DUNEURO_ANALYTIC_SOLUTION_TRACING
+
 /* end duneuro-analytic-solution
    Everything below here will be overwritten
 */
@@ -0,0 +1,420 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_BERG_APPROXIMATION_HH
+#define DUNEURO_ANALYTIC_SOLUTION_BERG_APPROXIMATION_HH
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <dune/duneuro-analytic-solution/tracing.hh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace duneuro {
+
+  // approximate evaluation of the EEG forward solution of a multilayer sphere model by the potentials of a few dipoles in a
+  // homogeneous sphere, see
+  // P. Berg, M. Scherg, A fast method for forward computation of multiple-shell spherical head models, 1994, and
+  // Z. Zhang, A fast method to compute surface potentials generated by dipoles within multilayer anisotropic spheres, 1995.
+  //
+  // With the series of AnalyticSolutionEEG, the multilayer potential of a dipole with moment q at r_0 = t * r_L * u equals
+  // 1 / (4 pi sigma_L r_L^2) * sum_n (2 + 1 / n) f_n t^(n-1) (...), where f_n = sigma_L / sigma_1 * h_n / (2 + 1 / n) and the
+  // brackets only depend on q, u and the electrode direction. For f_n = lambda * mu^(n-1), this is the potential of a dipole
+  // with moment lambda * q at mu * r_0 in a homogeneous sphere of radius r_L and conductivity sigma_L. Fitting
+  // f_n ~ sum_j lambda_j mu_j^(n-1) once per model therefore replaces the series by a few closed form homogeneous potentials.
+  //
+  // The eccentricities mu_j are optimized by a Nelder-Mead search, with the magnitudes lambda_j given by linear least squares,
+  // minimizing the residuals of f_n for n = 1, ..., fitOrder weighted by (r_1 / r_L)^(n-1), the decay of the terms for the
+  // most eccentric dipoles. The relative error of the potentials of radial and tangential dipoles at several eccentricities on
+  // a set of electrodes covering the sphere is reported by approximationError.
+  template<class FieldType>
+  class BergApproximationEEG
+  {
+  public:
+    using Solver = AnalyticSolutionEEG<FieldType>;
+    using Coordinate = typename Solver::Coordinate;
+    static constexpr size_t dim = Solver::dim;
+
+    // fit numberOfDipoles Berg parameters to the series of solver. Throws if the fit order exceeds the maximum order of solver.
+    BergApproximationEEG(const Solver& solver, size_t numberOfDipoles = 3, size_t fitOrder = 200)
+      : sphereCenter_(solver.sphereCenter())
+      , outerRadius_(solver.radii().back())
+      , outerConductivity_(solver.conductivities().back())
+      , innermostRadius_(solver.radii().front())
+    {
+      if(numberOfDipoles == 0) {
+        throw std::invalid_argument("the Berg approximation needs at least one dipole");
+      }
+      if(fitOrder < numberOfDipoles || fitOrder > solver.maximumOrder()) {
+        throw std::invalid_argument("the fit order has to lie between the number of dipoles and the maximum order of the solver");
+      }
+      fitParameters(solver, numberOfDipoles, fitOrder);
+      approximationError_ = measureApproximationError(solver);
+    }
+
+    const std::vector<FieldType>& eccentricities() const
+    {
+      return eccentricities_;
+    }
+
+    const std::vector<FieldType>& magnitudes() const
+    {
+      return magnitudes_;
+    }
+
+    // largest relative error, in the 2-norm over the electrodes, of the potentials of the test dipoles
+    FieldType approximationError() const
+    {
+      return approximationError_;
+    }
+
+    void bind(const Dipole<FieldType, dim>& dipole)
+    {
+      R_0 = dipole.position() - sphereCenter_;
+      moment_ = dipole.moment();
+    }
+
+    // approximate Solver::potential of the bound dipole
+    FieldType potential(const Coordinate& electrodePos) const
+    {
+      Coordinate direction = electrodeDirection(electrodePos);
+      Coordinate column;
+      leadFieldColumns(R_0, &direction, 1, &column);
+      return column * moment_;
+    }
+
+    std::vector<FieldType> potential(const std::vector<Coordinate>& electrodePositions) const
+    {
+      std::vector<Coordinate> directions(electrodePositions.size());
+      for(size_t k = 0; k < electrodePositions.size(); ++k) {
+        directions[k] = electrodeDirection(electrodePositions[k]);
+      }
+      std::vector<Coordinate> columns(electrodePositions.size());
+      leadFieldColumns(R_0, directions.data(), directions.size(), columns.data());
+      std::vector<FieldType> potentials(electrodePositions.size());
+      for(size_t k = 0; k < electrodePositions.size(); ++k) {
+        potentials[k] = columns[k] * moment_;
+      }
+      return potentials;
+    }
+
+    // approximate Solver::leadField, with the same layout and threading
+    std::vector<FieldType> leadField(const std::vector<Coordinate>& dipolePositions,
+                                     const std::vector<Coordinate>& electrodePositions,
+                                     size_t numberOfThreads = 0) const
+    {
+      TraceSpan span("bergLeadField", "job");
+      std::vector<Coordinate> directions(electrodePositions.size());
+      for(size_t k = 0; k < electrodePositions.size(); ++k) {
+        directions[k] = electrodeDirection(electrodePositions[k]);
+      }
+      const size_t numberOfColumns = dim * dipolePositions.size();
+      std::vector<FieldType> result(electrodePositions.size() * numberOfColumns);
+      parallelForBlocks(dipolePositions.size(), leadFieldBlockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        TraceSpan kernelSpan("kernel", "bergLeadField");
+        std::array<Coordinate, electrodeBlockSize> columns;
+        for(size_t electrodeBegin = 0; electrodeBegin < directions.size(); electrodeBegin += electrodeBlockSize) {
+          const size_t count = std::min(electrodeBlockSize, directions.size() - electrodeBegin);
+          for(size_t i = blockBegin; i < blockEnd; ++i) {
+            leadFieldColumns(dipolePositions[i] - sphereCenter_, directions.data() + electrodeBegin, count, columns.data());
+            for(size_t k = 0; k < count; ++k) {
+              std::copy(columns[k].begin(), columns[k].end(), result.begin() + (electrodeBegin + k) * numberOfColumns + dim * i);
+            }
+          }
+        }
+      });
+      return result;
+    }
+
+  private:
+    // set in constructor
+    Coordinate sphereCenter_;
+    FieldType outerRadius_;
+    FieldType outerConductivity_;
+    FieldType innermostRadius_;
+    std::vector<FieldType> eccentricities_;
+    std::vector<FieldType> magnitudes_;
+    FieldType approximationError_;
+
+    // set later on
+    Coordinate moment_;
+    Coordinate R_0;
+
+    static constexpr size_t leadFieldBlockSize = 16;
+    // number of electrodes evaluated side by side
+    static constexpr size_t electrodeBlockSize = 64;
+    static constexpr size_t maximumIterations = 4000;
+
+    // potentials of unit dipoles at dipolePos, relative to the sphere center, in x-, y- and z-direction at count electrodes in
+    // the given unit directions, as the sum of the homogeneous sphere potentials
+    // 1 / (4 pi sigma_L r_L^2) * (2 r_L^2 (r_e - r_0) / d^3 + (e + (r_e - r_0) / d) / (1 - (r_0 * e) / r_L + d / r_L))
+    // of the Berg dipoles. The electrodes are processed in blocks, with the components stored separately.
+    void leadFieldColumns(const Coordinate& dipolePos, const Coordinate* directions, size_t count, Coordinate* columns) const
+    {
+      const FieldType scale = 1.0 / (4.0 * M_PI * outerConductivity_ * outerRadius_ * outerRadius_);
+      std::array<std::array<FieldType, electrodeBlockSize>, dim> e, difference, sum;
+      std::array<FieldType, electrodeBlockSize> directionSum, projection;
+      for(size_t blockBegin = 0; blockBegin < count; blockBegin += electrodeBlockSize) {
+        const size_t blockCount = std::min(electrodeBlockSize, count - blockBegin);
+        for(size_t k = 0; k < blockCount; ++k) {
+          for(size_t c = 0; c < dim; ++c) {
+            e[c][k] = directions[blockBegin + k][c];
+            sum[c][k] = 0.0;
+          }
+          directionSum[k] = 0.0;
+          projection[k] = (dipolePos * directions[blockBegin + k]) / outerRadius_;
+        }
+        for(size_t j = 0; j < eccentricities_.size(); ++j) {
+          const FieldType mu = eccentricities_[j];
+          const FieldType lambda = magnitudes_[j];
+          for(size_t k = 0; k < blockCount; ++k) {
+            FieldType d2 = 0.0;
+            for(size_t c = 0; c < dim; ++c) {
+              difference[c][k] = outerRadius_ * e[c][k] - mu * dipolePos[c];
+              d2 += difference[c][k] * difference[c][k];
+            }
+            FieldType inverseD = 1.0 / std::sqrt(d2);
+            FieldType inverseDenominator = 1.0 / (1.0 - mu * projection[k] + d2 * inverseD / outerRadius_);
+            FieldType differenceFactor = lambda * inverseD * (2.0 * outerRadius_ * outerRadius_ * inverseD * inverseD + inverseDenominator);
+            for(size_t c = 0; c < dim; ++c) {
+              sum[c][k] += differenceFactor * difference[c][k];
+            }
+            directionSum[k] += lambda * inverseDenominator;
+          }
+        }
+        for(size_t k = 0; k < blockCount; ++k) {
+          for(size_t c = 0; c < dim; ++c) {
+            columns[blockBegin + k][c] = scale * (sum[c][k] + directionSum[k] * e[c][k]);
+          }
+        }
+      }
+    }
+
+    Coordinate electrodeDirection(const Coordinate& electrodePos) const
+    {
+      Coordinate direction = electrodePos - sphereCenter_;
+      FieldType norm = direction.two_norm();
+      if(norm == 0.0) {
+        throw std::invalid_argument("electrode at the sphere center");
+      }
+      direction /= norm;
+      return direction;
+    }
+
+    void fitParameters(const Solver& solver, size_t numberOfDipoles, size_t fitOrder)
+    {
+      const FieldType conductivityRatio = outerConductivity_ / solver.conductivities().front();
+      const FieldType decay = innermostRadius_ / outerRadius_;
+      std::vector<FieldType> targets(fitOrder);
+      std::vector<FieldType> weights(fitOrder);
+      FieldType weight = 1.0;
+      for(size_t n = 1; n <= fitOrder; ++n) {
+        targets[n - 1] = conductivityRatio * solver.seriesCoefficient(n) / (2.0 + 1.0 / n);
+        weights[n - 1] = weight;
+        weight *= decay;
+      }
+
+      // Nelder-Mead search over z_j with mu_j = 1 / (1 + exp(-z_j)), starting from eccentricities spread over [0.4, 0.9]
+      const size_t J = numberOfDipoles;
+      std::vector<std::vector<FieldType>> simplex(J + 1, std::vector<FieldType>(J));
+      for(size_t j = 0; j < J; ++j) {
+        FieldType mu = J > 1 ? 0.4 + 0.5 * j / (J - 1.0) : 0.9;
+        simplex[0][j] = std::log(mu / (1.0 - mu));
+      }
+      for(size_t vertex = 1; vertex <= J; ++vertex) {
+        simplex[vertex] = simplex[0];
+        simplex[vertex][vertex - 1] += 0.5;
+      }
+      std::vector<FieldType> values(J + 1);
+      std::vector<FieldType> lambda;
+      for(size_t vertex = 0; vertex <= J; ++vertex) {
+        values[vertex] = residual(simplex[vertex], targets, weights, lambda);
+      }
+
+      for(size_t iteration = 0; iteration < maximumIterations; ++iteration) {
+        std::vector<size_t> order(J + 1);
+        for(size_t vertex = 0; vertex <= J; ++vertex) {
+          order[vertex] = vertex;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return values[a] < values[b]; });
+        const size_t best = order.front();
+        const size_t worst = order.back();
+        const size_t secondWorst = order[J - 1];
+        if(values[worst] - values[best] <= 1e-15 * (values[best] + std::numeric_limits<FieldType>::min())) {
+          break;
+        }
+
+        std::vector<FieldType> centroid(J, 0.0);
+        for(size_t vertex = 0; vertex <= J; ++vertex) {
+          if(vertex != worst) {
+            for(size_t j = 0; j < J; ++j) {
+              centroid[j] += simplex[vertex][j] / J;
+            }
+          }
+        }
+        auto along = [&](FieldType factor) {
+          std::vector<FieldType> point(J);
+          for(size_t j = 0; j < J; ++j) {
+            point[j] = centroid[j] + factor * (simplex[worst][j] - centroid[j]);
+          }
+          return point;
+        };
+
+        auto reflected = along(-1.0);
+        FieldType reflectedValue = residual(reflected, targets, weights, lambda);
+        if(reflectedValue < values[best]) {
+          auto expanded = along(-2.0);
+          FieldType expandedValue = residual(expanded, targets, weights, lambda);
+          if(expandedValue < reflectedValue) {
+            simplex[worst] = expanded;
+            values[worst] = expandedValue;
+          }
+          else {
+            simplex[worst] = reflected;
+            values[worst] = reflectedValue;
+          }
+        }
+        else if(reflectedValue < values[secondWorst]) {
+          simplex[worst] = reflected;
+          values[worst] = reflectedValue;
+        }
+        else {
+          auto contracted = along(reflectedValue < values[worst] ? -0.5 : 0.5);
+          FieldType contractedValue = residual(contracted, targets, weights, lambda);
+          if(contractedValue < std::min(reflectedValue, values[worst])) {
+            simplex[worst] = contracted;
+            values[worst] = contractedValue;
+          }
+          else {
+            for(size_t vertex = 0; vertex <= J; ++vertex) {
+              if(vertex != best) {
+                for(size_t j = 0; j < J; ++j) {
+                  simplex[vertex][j] = simplex[best][j] + 0.5 * (simplex[vertex][j] - simplex[best][j]);
+                }
+                values[vertex] = residual(simplex[vertex], targets, weights, lambda);
+              }
+            }
+          }
+        }
+      }
+
+      size_t best = std::min_element(values.begin(), values.end()) - values.begin();
+      residual(simplex[best], targets, weights, magnitudes_);
+      eccentricities_.resize(J);
+      for(size_t j = 0; j < J; ++j) {
+        eccentricities_[j] = 1.0 / (1.0 + std::exp(-simplex[best][j]));
+      }
+    }
+
+    // weighted sum of squared residuals of the targets for the eccentricities given by z, with the optimal magnitudes lambda
+    static FieldType residual(const std::vector<FieldType>& z, const std::vector<FieldType>& targets,
+                              const std::vector<FieldType>& weights, std::vector<FieldType>& lambda)
+    {
+      const size_t J = z.size();
+      std::vector<FieldType> mu(J);
+      for(size_t j = 0; j < J; ++j) {
+        mu[j] = 1.0 / (1.0 + std::exp(-z[j]));
+      }
+      // normal equations of the weighted linear least squares problem for lambda
+      std::vector<FieldType> matrix(J * J, 0.0);
+      lambda.assign(J, 0.0);
+      std::vector<FieldType> powers(J, 1.0);
+      for(size_t n = 0; n < targets.size(); ++n) {
+        FieldType w2 = weights[n] * weights[n];
+        for(size_t i = 0; i < J; ++i) {
+          lambda[i] += w2 * powers[i] * targets[n];
+          for(size_t j = 0; j < J; ++j) {
+            matrix[i * J + j] += w2 * powers[i] * powers[j];
+          }
+        }
+        for(size_t j = 0; j < J; ++j) {
+          powers[j] *= mu[j];
+        }
+      }
+      // Gaussian elimination with partial pivoting
+      for(size_t column = 0; column < J; ++column) {
+        size_t pivot = column;
+        for(size_t row = column + 1; row < J; ++row) {
+          if(std::abs(matrix[row * J + column]) > std::abs(matrix[pivot * J + column])) {
+            pivot = row;
+          }
+        }
+        if(!(std::abs(matrix[pivot * J + column]) > 0.0)) {
+          return std::numeric_limits<FieldType>::max();
+        }
+        for(size_t j = 0; j < J; ++j) {
+          std::swap(matrix[column * J + j], matrix[pivot * J + j]);
+        }
+        std::swap(lambda[column], lambda[pivot]);
+        for(size_t row = column + 1; row < J; ++row) {
+          FieldType factor = matrix[row * J + column] / matrix[column * J + column];
+          for(size_t j = column; j < J; ++j) {
+            matrix[row * J + j] -= factor * matrix[column * J + j];
+          }
+          lambda[row] -= factor * lambda[column];
+        }
+      }
+      for(size_t row = J; row-- > 0;) {
+        for(size_t j = row + 1; j < J; ++j) {
+          lambda[row] -= matrix[row * J + j] * lambda[j];
+        }
+        lambda[row] /= matrix[row * J + row];
+      }
+
+      FieldType sum = 0.0;
+      std::fill(powers.begin(), powers.end(), 1.0);
+      for(size_t n = 0; n < targets.size(); ++n) {
+        FieldType approximation = 0.0;
+        for(size_t j = 0; j < J; ++j) {
+          approximation += lambda[j] * powers[j];
+          powers[j] *= mu[j];
+        }
+        FieldType r = weights[n] * (targets[n] - approximation);
+        sum += r * r;
+      }
+      return std::isfinite(sum) ? sum : std::numeric_limits<FieldType>::max();
+    }
+
+    // relative error of radial and tangential test dipoles at eccentricities up to 0.98 of the innermost radius, on a
+    // Fibonacci grid of electrodes
+    FieldType measureApproximationError(const Solver& solver) const
+    {
+      const size_t numberOfElectrodes = 256;
+      std::vector<Coordinate> electrodes(numberOfElectrodes);
+      for(size_t k = 0; k < numberOfElectrodes; ++k) {
+        FieldType z = 1.0 - (2.0 * k + 1.0) / numberOfElectrodes;
+        FieldType rho = std::sqrt(1.0 - z * z);
+        FieldType phi = M_PI * (3.0 - std::sqrt(5.0)) * k;
+        electrodes[k] = sphereCenter_;
+        electrodes[k].axpy(outerRadius_, Coordinate({rho * std::cos(phi), rho * std::sin(phi), z}));
+      }
+      const std::vector<FieldType> testEccentricities = {0.1, 0.3, 0.5, 0.7, 0.9, 0.98};
+      std::vector<Coordinate> dipolePositions;
+      for(FieldType eccentricity : testEccentricities) {
+        dipolePositions.push_back(sphereCenter_ + Coordinate({0.0, 0.0, eccentricity * innermostRadius_}));
+      }
+      auto exact = solver.leadField(dipolePositions, electrodes, 1);
+      auto approximate = leadField(dipolePositions, electrodes, 1);
+
+      // columns 3 * i and 3 * i + 2 belong to the tangential and the radial dipole
+      FieldType error = 0.0;
+      const size_t numberOfColumns = dim * dipolePositions.size();
+      for(size_t i = 0; i < dipolePositions.size(); ++i) {
+        for(size_t component : {size_t(0), size_t(2)}) {
+          FieldType differenceNorm = 0.0;
+          FieldType exactNorm = 0.0;
+          for(size_t k = 0; k < numberOfElectrodes; ++k) {
+            size_t index = k * numberOfColumns + dim * i + component;
+            differenceNorm += (approximate[index] - exact[index]) * (approximate[index] - exact[index]);
+            exactNorm += exact[index] * exact[index];
+          }
+          error = std::max(error, std::sqrt(differenceNorm / exactNorm));
+        }
+      }
+      return error;
+    }
+  }; // end class BergApproximationEEG
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_BERG_APPROXIMATION_HH
@@ -0,0 +1,113 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_CHANNEL_TRANSFORM_HH
+#define DUNEURO_ANALYTIC_SOLUTION_CHANNEL_TRANSFORM_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace duneuro {
+
+  // linear operator acting on the channels of a lead field, e.g. a synthetic gradiometer, an SSP projector, a fine calibration or
+  // a cross-talk matrix. The matrix maps #inputChannels channels to #outputChannels channels and is stored row major.
+  template<class FieldType>
+  class ChannelTransform {
+  public:
+    // throws if the matrix does not have #outputChannels x #inputChannels entries
+    ChannelTransform(size_t numberOfOutputChannels, size_t numberOfInputChannels, std::vector<FieldType> matrix)
+      : numberOfOutputChannels_(numberOfOutputChannels)
+      , numberOfInputChannels_(numberOfInputChannels)
+      , matrix_(std::move(matrix))
+    {
+      if(matrix_.size() != numberOfOutputChannels_ * numberOfInputChannels_) {
+        throw std::invalid_argument("size of the channel transform matrix does not match the number of channels");
+      }
+    }
+
+    // the transform applying first, then second
+    static ChannelTransform compose(const ChannelTransform& first, const ChannelTransform& second)
+    {
+      if(second.numberOfInputChannels_ != first.numberOfOutputChannels_) {
+        throw std::invalid_argument("channel transforms can not be chained, the number of channels differs");
+      }
+      std::vector<FieldType> matrix(second.numberOfOutputChannels_ * first.numberOfInputChannels_, 0.0);
+      for(size_t row = 0; row < second.numberOfOutputChannels_; ++row) {
+        for(size_t k = 0; k < first.numberOfOutputChannels_; ++k) {
+          FieldType factor = second.matrix_[row * second.numberOfInputChannels_ + k];
+          if(factor == 0.0) {
+            continue;
+          }
+          const FieldType* firstRow = first.matrix_.data() + k * first.numberOfInputChannels_;
+          FieldType* resultRow = matrix.data() + row * first.numberOfInputChannels_;
+          for(size_t column = 0; column < first.numberOfInputChannels_; ++column) {
+            resultRow[column] += factor * firstRow[column];
+          }
+        }
+      }
+      return ChannelTransform(second.numberOfOutputChannels_, first.numberOfInputChannels_, std::move(matrix));
+    }
+
+    // the transform applying the given transforms one after another. Throws if there are none.
+    static ChannelTransform compose(const std::vector<ChannelTransform>& transforms)
+    {
+      if(transforms.empty()) {
+        throw std::invalid_argument("no channel transforms to compose");
+      }
+      ChannelTransform result = transforms.front();
+      for(size_t i = 1; i < transforms.size(); ++i) {
+        result = compose(result, transforms[i]);
+      }
+      return result;
+    }
+
+    // apply the transform to a row major block with #inputChannels rows and the given number of columns, writing the
+    // #outputChannels rows of the result into output. The output rows are computed in groups of outputRowBlockSize, so that
+    // every input row is loaded once per group, and zero entries of the matrix are skipped, so that sparse operators like
+    // synthetic gradiometers only touch the rows they reference.
+    void apply(const FieldType* input, size_t numberOfColumns, FieldType* output) const
+    {
+      std::fill(output, output + numberOfOutputChannels_ * numberOfColumns, FieldType(0.0));
+      for(size_t rowBegin = 0; rowBegin < numberOfOutputChannels_; rowBegin += outputRowBlockSize) {
+        const size_t rowEnd = std::min(rowBegin + outputRowBlockSize, numberOfOutputChannels_);
+        for(size_t k = 0; k < numberOfInputChannels_; ++k) {
+          const FieldType* inputRow = input + k * numberOfColumns;
+          for(size_t row = rowBegin; row < rowEnd; ++row) {
+            const FieldType factor = matrix_[row * numberOfInputChannels_ + k];
+            if(factor == 0.0) {
+              continue;
+            }
+            FieldType* outputRow = output + row * numberOfColumns;
+            for(size_t column = 0; column < numberOfColumns; ++column) {
+              outputRow[column] += factor * inputRow[column];
+            }
+          }
+        }
+      }
+    }
+
+    size_t numberOfOutputChannels() const
+    {
+      return numberOfOutputChannels_;
+    }
+
+    size_t numberOfInputChannels() const
+    {
+      return numberOfInputChannels_;
+    }
+
+    const std::vector<FieldType>& matrix() const
+    {
+      return matrix_;
+    }
+
+  private:
+    static constexpr size_t outputRowBlockSize = 8;
+
+    size_t numberOfOutputChannels_;
+    size_t numberOfInputChannels_;
+    std::vector<FieldType> matrix_;
+  }; // end class ChannelTransform
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_CHANNEL_TRANSFORM_HH
@@ -3,9 +3,33 @@
 
 #include <dune/common/fvector.hh>
 #include <duneuro/common/dipole.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <dune/duneuro-analytic-solution/instrumentation.hh>
+#include <dune/duneuro-analytic-solution/tracing.hh>
+#include <dune/duneuro-analytic-solution/rigid-transform.hh>
+#include <dune/duneuro-analytic-solution/multi-axis-sensor.hh>
+#include <dune/duneuro-analytic-solution/channel-transform.hh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace duneuro {
 
+  // read only view of a mapped point set file, see point-set-file.hh, which has to be included to use the overloads taking it.
+  // The core header does not include it, since mapping files needs POSIX.
+  template<class FieldType>
+  class PointSetView;
+
+  // quadrature of patch sources, see patch-sources.hh, which has to be included to build it and to use the overloads taking it.
+  // The core header does not include it, since the quadrature rules need dune-geometry.
+  template<class FieldType>
+  struct PatchQuadrature;
+
   // implements the analytic MEG forwad solution for multilayer sphere models in 3 dimensions
   // We assume layer wise isotropic conductivity
   template<class FieldType>
@@ -14,6 +38,7 @@ namespace duneuro {
   public:
     static constexpr size_t dim = 3;
     using Coordinate = Dune::FieldVector<FieldType, dim>;
+    using ComplexCoordinate = Dune::FieldVector<std::complex<FieldType>, dim>;
   
     // constructor
     AnalyticSolutionMEG(const Coordinate& sphereCenter, FieldType scalingFactor = 1.0)
@@ -21,11 +46,35 @@ namespace duneuro {
       , scalingFactor_(scalingFactor)
     {
     }
+    
+    const Coordinate& sphereCenter() const
+    {
+      return sphereCenter_;
+    }
+    
+    FieldType scalingFactor() const
+    {
+      return scalingFactor_;
+    }
   
     void bind(const Dipole<FieldType, dim>& dipole)
     {
+      auto timer = instrumentation_.timer(InstrumentedPhase::bind);
       R_0 = dipole.position() - sphereCenter_;
       moment_ = dipole.moment();
+      imaginaryMoment_ = 0.0;
+    }
+    
+    // bind a dipole with a complex moment, e.g. the Fourier coefficient of a source at one frequency. The real part serves as the
+    // moment of the real valued methods, while the complex valued methods below return the fields of the complex moment.
+    void bind(const Coordinate& position, const ComplexCoordinate& moment)
+    {
+      auto timer = instrumentation_.timer(InstrumentedPhase::bind);
+      R_0 = position - sphereCenter_;
+      for(size_t j = 0; j < dim; ++j) {
+        moment_[j] = moment[j].real();
+        imaginaryMoment_[j] = moment[j].imag();
+      }
     }
     
     //////////////////////////////////
@@ -36,60 +85,569 @@ namespace duneuro {
     // Basic mathematical and electromagnetic concepts of the biomagnetic inverse problem, Jukka Sarvas, 1987, §4
     Coordinate totalField(const Coordinate& coilPos)
     {
+      instrumentation_.countEvaluations(InstrumentedMethod::totalField, 1);
       Coordinate R = coilPos - sphereCenter_;
-      Coordinate A = R - R_0;
-      FieldType r = R.two_norm();
-      FieldType a = A.two_norm();
-      
-      FieldType F = a * (r * a + r * r - R_0 * R);
-      
-      Coordinate grad_F = (a*a/r + A * R/a + 2*(a + r)) * R - (a + 2*r + A * R/a)* R_0; 
+      FieldType F;
+      Coordinate grad_F;
+      {
+        auto timer = instrumentation_.timer(InstrumentedPhase::geometry);
+        sarvasGeometry(R_0, R, F, grad_F);
+      }
       
+      auto timer = instrumentation_.timer(InstrumentedPhase::kernel);
       return scalingFactor_ * (F * crossProduct(moment_, R_0) - (crossProduct(moment_, R_0) * R) * grad_F) / (F * F);
     }
     
     FieldType totalField(const Coordinate& coilPos, const Coordinate& direction)
     {
-      return totalField(coilPos) * direction;
+      Coordinate field = totalField(coilPos);
+      auto timer = instrumentation_.timer(InstrumentedPhase::reduction);
+      return field * direction;
+    }
+    
+    // compute the magnetic scalar potential W of the total field outside of the conductor, such that totalField = grad W, i.e.
+    // W = scalingFactor * ((moment x R_0) * R) / F, see Sarvas 1987, §4
+    FieldType scalarPotential(const Coordinate& coilPos) const
+    {
+      Coordinate R = coilPos - sphereCenter_;
+      FieldType r = R.two_norm();
+      FieldType a = (R - R_0).two_norm();
+      FieldType F = a * (r * a + r * r - R_0 * R);
+      instrumentation_.checkNearSingular(F, r);
+      return scalingFactor_ * (crossProduct(moment_, R_0) * R) / F;
     }
     
     // compute primary field
     Coordinate primaryField(const Coordinate& coilPos)
     {
+      instrumentation_.countEvaluations(InstrumentedMethod::primaryField, 1);
+      auto timer = instrumentation_.timer(InstrumentedPhase::kernel);
       Coordinate R = coilPos - sphereCenter_;
       Coordinate diff = R - R_0;
       FieldType diffNorm = diff.two_norm();
+      instrumentation_.checkNearSingular(diffNorm * diffNorm * diffNorm, R.two_norm());
       diff /= (diffNorm * diffNorm * diffNorm);
       return scalingFactor_ * crossProduct(moment_, diff);
     }
     
     FieldType primaryField(const Coordinate& coilPos, const Coordinate& direction)
     {
-      return primaryField(coilPos) * direction;
+      Coordinate field = primaryField(coilPos);
+      auto timer = instrumentation_.timer(InstrumentedPhase::reduction);
+      return field * direction;
     }
     
     // compute secondary field
     Coordinate secondaryField(const Coordinate& coilPos)
     {
+      instrumentation_.countEvaluations(InstrumentedMethod::secondaryField, 1);
       return primaryField(coilPos) - totalField(coilPos);
     }
     
     FieldType secondaryField(const Coordinate& coilPos, const Coordinate& direction)
     {
+      instrumentation_.countEvaluations(InstrumentedMethod::secondaryField, 1);
       return primaryField(coilPos, direction) - totalField(coilPos, direction);
     }
     
-  private:
-    //set in constructor
-    Coordinate sphereCenter_;
-    FieldType scalingFactor_;
+    //////////////////////////////////
+    // batched versions of the methods above, evaluating the fields of the bound dipole at a whole set of coils
+    //////////////////////////////////
     
-    // set later on
-    Coordinate moment_;
-    Coordinate R_0;
+    std::vector<Coordinate> totalField(const std::vector<Coordinate>& coilPositions)
+    {
+      std::vector<Coordinate> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = totalField(coilPositions[i]);
+      }
+      return fields;
+    }
+    
+    std::vector<FieldType> totalField(const std::vector<Coordinate>& coilPositions, const std::vector<Coordinate>& directions)
+    {
+      checkSameSize(coilPositions, directions);
+      std::vector<FieldType> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = totalField(coilPositions[i], directions[i]);
+      }
+      return fields;
+    }
+    
+    std::vector<Coordinate> primaryField(const std::vector<Coordinate>& coilPositions)
+    {
+      std::vector<Coordinate> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = primaryField(coilPositions[i]);
+      }
+      return fields;
+    }
+    
+    std::vector<FieldType> primaryField(const std::vector<Coordinate>& coilPositions, const std::vector<Coordinate>& directions)
+    {
+      checkSameSize(coilPositions, directions);
+      std::vector<FieldType> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = primaryField(coilPositions[i], directions[i]);
+      }
+      return fields;
+    }
+    
+    std::vector<Coordinate> secondaryField(const std::vector<Coordinate>& coilPositions)
+    {
+      std::vector<Coordinate> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = secondaryField(coilPositions[i]);
+      }
+      return fields;
+    }
+    
+    std::vector<FieldType> secondaryField(const std::vector<Coordinate>& coilPositions, const std::vector<Coordinate>& directions)
+    {
+      checkSameSize(coilPositions, directions);
+      std::vector<FieldType> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = secondaryField(coilPositions[i], directions[i]);
+      }
+      return fields;
+    }
+    
+    // compute the total fields of the bound dipole at multi-axis sensors, one entry per sensor axis, the axes of a sensor following
+    // each other. The field vector is computed once per sensor and projected onto all of its axes.
+    std::vector<FieldType> totalField(const std::vector<MultiAxisSensor<FieldType>>& sensors)
+    {
+      std::vector<FieldType> fields;
+      for(const auto& sensor : sensors) {
+        Coordinate field = totalField(sensor.position);
+        for(size_t axis = 0; axis < sensor.numberOfAxes; ++axis) {
+          fields.push_back(field * sensor.axes[axis]);
+        }
+      }
+      return fields;
+    }
+    
+    //////////////////////////////////
+    // complex valued fields of a dipole with a complex moment
+    //////////////////////////////////
+    
+    // compute the total field of the bound complex moment. Since the geometry is real and the field is linear in the moment, F and
+    // grad_F are evaluated once and applied to the real and the imaginary part of moment x R_0.
+    ComplexCoordinate complexTotalField(const Coordinate& coilPos)
+    {
+      instrumentation_.countEvaluations(InstrumentedMethod::totalField, 1);
+      Coordinate R = coilPos - sphereCenter_;
+      FieldType F;
+      Coordinate grad_F;
+      {
+        auto timer = instrumentation_.timer(InstrumentedPhase::geometry);
+        sarvasGeometry(R_0, R, F, grad_F);
+      }
+      
+      auto timer = instrumentation_.timer(InstrumentedPhase::kernel);
+      Coordinate realQ = crossProduct(moment_, R_0);
+      Coordinate imaginaryQ = crossProduct(imaginaryMoment_, R_0);
+      Coordinate realField = F * realQ - (realQ * R) * grad_F;
+      Coordinate imaginaryField = F * imaginaryQ - (imaginaryQ * R) * grad_F;
+      FieldType scale = scalingFactor_ / (F * F);
+      ComplexCoordinate field;
+      for(size_t j = 0; j < dim; ++j) {
+        field[j] = std::complex<FieldType>(scale * realField[j], scale * imaginaryField[j]);
+      }
+      return field;
+    }
+    
+    std::complex<FieldType> complexTotalField(const Coordinate& coilPos, const Coordinate& direction)
+    {
+      ComplexCoordinate field = complexTotalField(coilPos);
+      return field[0] * direction[0] + field[1] * direction[1] + field[2] * direction[2];
+    }
+    
+    std::vector<ComplexCoordinate> complexTotalField(const std::vector<Coordinate>& coilPositions)
+    {
+      std::vector<ComplexCoordinate> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = complexTotalField(coilPositions[i]);
+      }
+      return fields;
+    }
+    
+    std::vector<std::complex<FieldType>> complexTotalField(const std::vector<Coordinate>& coilPositions, const std::vector<Coordinate>& directions)
+    {
+      checkSameSize(coilPositions, directions);
+      std::vector<std::complex<FieldType>> fields(coilPositions.size());
+      for(size_t i = 0; i < coilPositions.size(); ++i) {
+        fields[i] = complexTotalField(coilPositions[i], directions[i]);
+      }
+      return fields;
+    }
+    
+    //////////////////////////////////
+    // lead field computation
+    //////////////////////////////////
+    
+    // compute the lead field of the total field for the given dipole positions and coils. The result is a row major matrix
+    // of size #coils x (3 * #dipolePositions), where the columns 3 * i, 3 * i + 1 and 3 * i + 2 contain the fields of unit dipoles at
+    // dipolePositions[i] pointing in x-, y- and z-direction. The dipole positions are distributed in blocks over numberOfThreads
+    // threads, where 0 means one thread per hardware thread. Every thread computes the columns of its block for all coils into a
+    // small tile, which is then copied into the result. The channelTransforms, e.g. synthetic gradiometers, SSP projectors or fine
+    // calibration and cross-talk matrices, are applied one after another to the rows of every tile before it is copied, so that
+    // the result has #outputChannels rows of the last transform and the untransformed lead field is never stored. The same holds
+    // for all lead field builders below.
+    //
+    // Since the field is linear in the moment, we evaluate the geometry terms F and grad_F only once per dipole position and coil. For
+    // the moment e_k we have (e_k x R_0) * d = (R_0 x d)_k and (e_k x R_0) * R = (R_0 x R)_k, so that the three columns are given by
+    // scalingFactor * (F * (R_0 x d) - (grad_F * d) * (R_0 x R)) / F^2.
+    std::vector<FieldType> leadField(const std::vector<Coordinate>& dipolePositions,
+                                     const std::vector<Coordinate>& coilPositions,
+                                     const std::vector<Coordinate>& coilDirections,
+                                     size_t numberOfThreads = 0,
+                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("leadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return leadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead field for multi-axis sensors as in leadField, with one row per sensor axis, the axes of a sensor following
+    // each other. F and grad_F are evaluated once per dipole position and sensor for all axes.
+    std::vector<FieldType> leadField(const std::vector<Coordinate>& dipolePositions,
+                                     const std::vector<MultiAxisSensor<FieldType>>& sensors,
+                                     size_t numberOfThreads = 0,
+                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("leadField", "job");
+      return leadField(dipolePositions, sensorPositions(sensors), CoilAxes{nullptr, sensors.data(), nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead field of leadField preceded by numberOfLeadingRows rows of another modality, e.g. the EEG rows of
+    // jointLeadField, in the same pass over the dipole positions. For every block of dipole positions,
+    // leadingRows(blockBegin, blockEnd, dipolePos, tile, rowStride) writes the rows of the positions blockBegin, ..., blockEnd - 1
+    // into the rows tile, tile + rowStride, ... of the tile of the block, with dipolePos[i - blockBegin] the position relative to
+    // the sphere center, such that the positions are centered once for both modalities.
+    template<class LeadingRows>
+    std::vector<FieldType> leadFieldWithLeadingRows(const std::vector<Coordinate>& dipolePositions,
+                                                    const std::vector<Coordinate>& coilPositions,
+                                                    const std::vector<Coordinate>& coilDirections,
+                                                    size_t numberOfLeadingRows, LeadingRows leadingRows,
+                                                    size_t numberOfThreads = 0) const
+    {
+      checkSameSize(coilPositions, coilDirections);
+      return assembleLeadField<dim>(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads,
+                                    totalFieldKernel(), {}, 1, numberOfLeadingRows, leadingRows);
+    }
+    
+    // compute the lead field of leadField for the dipole positions of a mapped point set file. The positions of every block are
+    // gathered from the arrays of the file by the thread computing the block, so that the source space is neither parsed nor
+    // copied as a whole.
+    std::vector<FieldType> leadField(const PointSetView<FieldType>& dipolePositions,
+                                     const std::vector<Coordinate>& coilPositions,
+                                     const std::vector<Coordinate>& coilDirections,
+                                     size_t numberOfThreads = 0,
+                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("leadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return leadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // orthonormal basis t_1, t_2 of the plane orthogonal to the dipole position relative to the sphere center, such that
+    // (t_1, t_2, u) is right handed for the radial direction u. For a dipole at the center, any orthonormal pair is returned.
+    std::array<Coordinate, 2> tangentialBasis(const Coordinate& dipolePosition) const
+    {
+      Coordinate u = dipolePosition - sphereCenter_;
+      FieldType r0 = u.two_norm();
+      if(r0 > 0.0) {
+        u /= r0;
+      }
+      else {
+        u = {0.0, 0.0, 1.0};
+      }
+      // start from the coordinate axis closest to orthogonal to u
+      size_t axis = 0;
+      for(size_t k = 1; k < dim; ++k) {
+        if(std::abs(u[k]) < std::abs(u[axis])) {
+          axis = k;
+        }
+      }
+      Coordinate t1(0.0);
+      t1[axis] = 1.0;
+      t1.axpy(-u[axis], u);
+      t1 /= t1.two_norm();
+      return {{t1, crossProduct(u, t1)}};
+    }
+    
+    // compute the lead field of the total field for the two tangential orientations of every dipole position. Since a radial
+    // dipole produces no field outside of a spherical conductor, (moment x R_0) vanishing, this contains the same information as
+    // leadField with two thirds of the entries. The result is a row major matrix of size #coils x (2 * #dipolePositions), where
+    // the columns 2 * i and 2 * i + 1 contain the fields of unit dipoles at dipolePositions[i] pointing in the directions
+    // tangentialBasis(dipolePositions[i]). Threads are used as in leadField.
+    //
+    // For the basis (t_1, t_2, u) we have t_1 x R_0 = -r_0 * t_2 and t_2 x R_0 = r_0 * t_1, so that the columns are given by
+    // scalingFactor * r_0 * (-F * (t_2 * d) + (t_2 * R) * (grad_F * d)) / F^2 and
+    // scalingFactor * r_0 * (F * (t_1 * d) - (t_1 * R) * (grad_F * d)) / F^2.
+    std::vector<FieldType> tangentialLeadField(const std::vector<Coordinate>& dipolePositions,
+                                               const std::vector<Coordinate>& coilPositions,
+                                               const std::vector<Coordinate>& coilDirections,
+                                               size_t numberOfThreads = 0,
+                                               const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("tangentialLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return tangentialLeadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // tangential lead field for multi-axis sensors, with one row per sensor axis
+    std::vector<FieldType> tangentialLeadField(const std::vector<Coordinate>& dipolePositions,
+                                               const std::vector<MultiAxisSensor<FieldType>>& sensors,
+                                               size_t numberOfThreads = 0,
+                                               const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("tangentialLeadField", "job");
+      return tangentialLeadField(dipolePositions, sensorPositions(sensors), CoilAxes{nullptr, sensors.data(), nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead field of the total field for sources with fixed orientations, e.g. along the normals of a cortical surface.
+    // The result is a row major matrix of size #coils x #dipolePositions, where column i contains the field of a dipole at
+    // dipolePositions[i] with moment dipoleOrientations[i]. The orientations are not normalized. Threads are used as in leadField.
+    // Since q = orientation x R_0 is computed once per source, every entry costs one evaluation of
+    // scalingFactor * (F * (q * d) - (q * R) * (grad_F * d)) / F^2.
+    std::vector<FieldType> fixedOrientationLeadField(const std::vector<Coordinate>& dipolePositions,
+                                                     const std::vector<Coordinate>& dipoleOrientations,
+                                                     const std::vector<Coordinate>& coilPositions,
+                                                     const std::vector<Coordinate>& coilDirections,
+                                                     size_t numberOfThreads = 0,
+                                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("fixedOrientationLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return fixedOrientationLeadField(dipolePositions, dipoleOrientations, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // fixed orientation lead field for multi-axis sensors, with one row per sensor axis
+    std::vector<FieldType> fixedOrientationLeadField(const std::vector<Coordinate>& dipolePositions,
+                                                     const std::vector<Coordinate>& dipoleOrientations,
+                                                     const std::vector<MultiAxisSensor<FieldType>>& sensors,
+                                                     size_t numberOfThreads = 0,
+                                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("fixedOrientationLeadField", "job");
+      return fixedOrientationLeadField(dipolePositions, dipoleOrientations, sensorPositions(sensors), CoilAxes{nullptr, sensors.data(), nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead field of the total field for extended sources, i.e. patches with a uniform normal current density of unit
+    // strength discretized by makePatchQuadrature. The result is a row major matrix of size #coils x #patches, where column p
+    // contains the field of patch p. Every patch is handled like a single source of fixedOrientationLeadField, whose kernel sums
+    // the fields of all quadrature points of the patch directly into the entries of the tile, so that the fields of single
+    // quadrature points are never stored. Threads are used as in leadField.
+    std::vector<FieldType> patchLeadField(const PatchQuadrature<FieldType>& patches,
+                                          const std::vector<Coordinate>& coilPositions,
+                                          const std::vector<Coordinate>& coilDirections,
+                                          size_t numberOfThreads = 0,
+                                          const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("patchLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return patchLeadField(patches, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // patch lead field for multi-axis sensors, with one row per sensor axis
+    std::vector<FieldType> patchLeadField(const PatchQuadrature<FieldType>& patches,
+                                          const std::vector<MultiAxisSensor<FieldType>>& sensors,
+                                          size_t numberOfThreads = 0,
+                                          const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("patchLeadField", "job");
+      return patchLeadField(patches, sensorPositions(sensors), CoilAxes{nullptr, sensors.data(), nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead fields of the total field for dipoles fixed in the head and coils fixed in the device for several head
+    // poses, where every pose maps head coordinates, in which the sphere center and the dipole positions are given, to device
+    // coordinates, in which the coils are given. The result contains the #coils x (3 * #dipolePositions) lead fields of
+    // leadField for all poses one after another, with columns for unit dipoles in x-, y- and z-direction of the head.
+    //
+    // Since the sphere model moves with the head, the coils of every pose are mapped into head coordinates once, which costs
+    // O(#coils) per pose, independent of the size of the source space, and leaves the columns in head coordinates. All poses are
+    // computed in one parallel job over the pairs of pose and block of dipole positions.
+    std::vector<FieldType> leadField(const std::vector<RigidTransform<FieldType>>& poses,
+                                     const std::vector<Coordinate>& dipolePositions,
+                                     const std::vector<Coordinate>& coilPositions,
+                                     const std::vector<Coordinate>& coilDirections,
+                                     size_t numberOfThreads = 0,
+                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("leadFieldPoses", "job");
+      checkSameSize(coilPositions, coilDirections);
+      const size_t numberOfCoils = coilPositions.size();
+      std::vector<Coordinate> headCoilPositions(poses.size() * numberOfCoils);
+      std::vector<Coordinate> headCoilDirections(poses.size() * numberOfCoils);
+      for(size_t pose = 0; pose < poses.size(); ++pose) {
+        for(size_t coil = 0; coil < numberOfCoils; ++coil) {
+          headCoilPositions[pose * numberOfCoils + coil] = poses[pose].applyInverseToPosition(coilPositions[coil]);
+          headCoilDirections[pose * numberOfCoils + coil] = poses[pose].applyInverseToDirection(coilDirections[coil]);
+        }
+      }
+      return leadField(dipolePositions, headCoilPositions, CoilAxes{headCoilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms, poses.size());
+    }
+    
+    // compute the lead fields of the primary and the secondary field, as returned by primaryField and secondaryField, with the
+    // layout and threads of leadField. The columns of the primary field are scalingFactor * ((R - R_0) x d) / |R - R_0|^3.
+    std::vector<FieldType> primaryLeadField(const std::vector<Coordinate>& dipolePositions,
+                                            const std::vector<Coordinate>& coilPositions,
+                                            const std::vector<Coordinate>& coilDirections,
+                                            size_t numberOfThreads = 0,
+                                            const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("primaryLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return primaryLeadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    std::vector<FieldType> secondaryLeadField(const std::vector<Coordinate>& dipolePositions,
+                                              const std::vector<Coordinate>& coilPositions,
+                                              const std::vector<Coordinate>& coilDirections,
+                                              size_t numberOfThreads = 0,
+                                              const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("secondaryLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return secondaryLeadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead fields of primaryLeadField and secondaryLeadField for the dipole positions of a mapped point set file, see
+    // the corresponding overload of leadField
+    std::vector<FieldType> primaryLeadField(const PointSetView<FieldType>& dipolePositions,
+                                            const std::vector<Coordinate>& coilPositions,
+                                            const std::vector<Coordinate>& coilDirections,
+                                            size_t numberOfThreads = 0,
+                                            const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("primaryLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return primaryLeadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    std::vector<FieldType> secondaryLeadField(const PointSetView<FieldType>& dipolePositions,
+                                              const std::vector<Coordinate>& coilPositions,
+                                              const std::vector<Coordinate>& coilDirections,
+                                              size_t numberOfThreads = 0,
+                                              const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("secondaryLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      return secondaryLeadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, nullptr}, numberOfThreads, channelTransforms);
+    }
+    
+    // compute the lead field of leadField for a local sphere model, where every coil has its own sphere center, fitted to the head
+    // surface near the coil, in place of the sphere center of the solver. Coils sharing a center are evaluated together, with the
+    // dipole positions taken relative to the center once per group and block of dipole positions, and the whole lead field is
+    // computed in one parallel pass.
+    std::vector<FieldType> localSphereLeadField(const std::vector<Coordinate>& dipolePositions,
+                                                const std::vector<Coordinate>& coilPositions,
+                                                const std::vector<Coordinate>& coilDirections,
+                                                const std::vector<Coordinate>& sphereCenters,
+                                                size_t numberOfThreads = 0,
+                                                const std::vector<ChannelTransform<FieldType>>& channelTransforms = {}) const
+    {
+      TraceSpan span("localSphereLeadField", "job");
+      checkSameSize(coilPositions, coilDirections);
+      if(coilPositions.size() != sphereCenters.size()) {
+        throw std::invalid_argument("number of coil positions and number of sphere centers differ");
+      }
+      return leadField(dipolePositions, coilPositions, CoilAxes{coilDirections.data(), nullptr, sphereCenters.data()}, numberOfThreads, channelTransforms);
+    }
+    
+    //////////////////////////////////
+    // field time series for moving coils
+    //////////////////////////////////
+    
+    // compute the time series of the total field of a fixed set of dipoles at moving coils, e.g. wearable OPM sensors.
+    // coilPositions and coilDirections contain the geometry of numberOfCoils coils for every sample, one sample after another.
+    // dipoleMoments contains either one moment per dipole, used for all samples, or the moments of all dipoles for every sample,
+    // one sample after another. The result is a row major matrix of size #samples x numberOfCoils containing the summed fields of
+    // all dipoles. The pairs of sample and coil are distributed in blocks over numberOfThreads threads, where 0 means one thread per
+    // hardware thread. Since samples are independent, long recordings can be processed chunk by chunk.
+    //
+    // For every pair of sample and coil, the dipoles are traversed as a contiguous array, where q = moment x R_0 is computed once
+    // per dipole if the moments are fixed.
+    std::vector<FieldType> totalFieldTimeSeries(const std::vector<Coordinate>& dipolePositions,
+                                                const std::vector<Coordinate>& dipoleMoments,
+                                                const std::vector<Coordinate>& coilPositions,
+                                                const std::vector<Coordinate>& coilDirections,
+                                                size_t numberOfCoils, size_t numberOfThreads = 0) const
+    {
+      TraceSpan span("totalFieldTimeSeries", "job");
+      checkSameSize(coilPositions, coilDirections);
+      const size_t numberOfDipoles = dipolePositions.size();
+      if(numberOfCoils == 0 || coilPositions.size() % numberOfCoils != 0) {
+        throw std::invalid_argument("number of coil positions is not a multiple of the number of coils");
+      }
+      const size_t numberOfSamples = coilPositions.size() / numberOfCoils;
+      const bool fixedMoments = dipoleMoments.size() == numberOfDipoles;
+      if(!fixedMoments && dipoleMoments.size() != numberOfSamples * numberOfDipoles) {
+        throw std::invalid_argument("expected one moment per dipole or one moment per dipole and sample");
+      }
+      instrumentation_.countEvaluations(InstrumentedMethod::totalField, coilPositions.size() * numberOfDipoles);
+      
+      std::vector<Coordinate> dipolePos(numberOfDipoles);
+      std::vector<Coordinate> q(fixedMoments ? numberOfDipoles : 0);
+      for(size_t i = 0; i < numberOfDipoles; ++i) {
+        dipolePos[i] = dipolePositions[i] - sphereCenter_;
+        if(fixedMoments) {
+          q[i] = crossProduct(dipoleMoments[i], dipolePos[i]);
+        }
+      }
+      
+      std::vector<FieldType> result(coilPositions.size());
+      auto regionStart = instrumentation_.now();
+      size_t threadsUsed = parallelForBlocks(coilPositions.size(), timeSeriesBlockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        auto busyTimer = instrumentation_.busyTimer();
+        TraceSpan kernelSpan("kernel", "totalFieldTimeSeries");
+        auto kernelTimer = instrumentation_.timer(InstrumentedPhase::kernel);
+        for(size_t entry = blockBegin; entry < blockEnd; ++entry) {
+          const Coordinate R = coilPositions[entry] - sphereCenter_;
+          const Coordinate& direction = coilDirections[entry];
+          const Coordinate* moments = fixedMoments ? nullptr : dipoleMoments.data() + (entry / numberOfCoils) * numberOfDipoles;
+          FieldType field = 0.0;
+          for(size_t i = 0; i < numberOfDipoles; ++i) {
+            FieldType F;
+            Coordinate grad_F;
+            sarvasGeometry(dipolePos[i], R, F, grad_F);
+            Coordinate qi = fixedMoments ? q[i] : crossProduct(moments[i], dipolePos[i]);
+            field += (F * (qi * direction) - (qi * R) * (grad_F * direction)) / (F * F);
+          }
+          result[entry] = scalingFactor_ * field;
+        }
+      });
+      instrumentation_.recordParallelRegion(regionStart, threadsUsed);
+      
+      return result;
+    }
+    
+    // compute the lead field of a single dipole position, i.e. a row major matrix of size #coils x 3, in the calling thread
+    std::vector<FieldType> leadField(const Coordinate& dipolePosition,
+                                     const std::vector<Coordinate>& coilPositions,
+                                     const std::vector<Coordinate>& coilDirections) const
+    {
+      checkSameSize(coilPositions, coilDirections);
+      instrumentation_.countEvaluations(InstrumentedMethod::leadField, coilPositions.size());
+      auto kernelTimer = instrumentation_.timer(InstrumentedPhase::kernel);
+      std::vector<FieldType> result(dim * coilPositions.size());
+      Coordinate position = dipolePosition - sphereCenter_;
+      for(size_t coil = 0; coil < coilPositions.size(); ++coil) {
+        Coordinate columns = totalFieldLeadFieldColumns(position, coilPositions[coil] - sphereCenter_, coilDirections[coil]);
+        std::copy(columns.begin(), columns.end(), result.begin() + dim * coil);
+      }
+      return result;
+    }
+    
+    // compute one row of the lead field, i.e. the projections of the total fields of unit dipoles at dipolePosition in x-, y- and
+    // z-direction onto direction at coilPosition, without binding a dipole
+    Coordinate leadFieldColumns(const Coordinate& dipolePosition, const Coordinate& coilPosition, const Coordinate& direction) const
+    {
+      return totalFieldLeadFieldColumns(dipolePosition - sphereCenter_, coilPosition - sphereCenter_, direction);
+    }
     
     // compute the cross prodcut of two vectors. Copied from dune/pdelab/common/crossproduct.hh
-    Coordinate crossProduct(const Coordinate& vec_1, const Coordinate& vec_2)
+    static Coordinate crossProduct(const Coordinate& vec_1, const Coordinate& vec_2)
     {
       Coordinate crossProd;
       for(size_t i = 0; i < 3; ++i) {
@@ -101,7 +659,733 @@ namespace duneuro {
       
       return crossProd;
     }
+    
+    //////////////////////////////////
+    // instrumentation
+    //////////////////////////////////
+    
+    // counters collected since construction or the last reset. Only filled if DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION is
+    // enabled, otherwise statistics().enabled is false and all counters are zero.
+    InstrumentationStatistics statistics() const
+    {
+      return instrumentation_.statistics();
+    }
+    
+    void resetStatistics()
+    {
+      instrumentation_.reset();
+    }
+    
+  private:
+    //set in constructor
+    Coordinate sphereCenter_;
+    FieldType scalingFactor_;
+    
+    // set later on
+    Coordinate moment_;
+    Coordinate imaginaryMoment_;
+    Coordinate R_0;
+    
+    Instrumentation instrumentation_;
+    
+    // number of dipole positions a thread processes at once during lead field computation. Small enough to keep the tile of a few
+    // hundred coils in the L2 cache.
+    static constexpr size_t leadFieldBlockSize = 16;
+    // number of pairs of sample and coil a thread processes at once in totalFieldTimeSeries
+    static constexpr size_t timeSeriesBlockSize = 64;
+    
+    // measurement axes of a set of coils, either one direction per coil or the axes of multi-axis sensors, and the sphere center
+    // of every coil for local sphere models, where nullptr means sphereCenter_ for all coils
+    struct CoilAxes {
+      const Coordinate* directions;
+      const MultiAxisSensor<FieldType>* sensors;
+      const Coordinate* centers;
+      
+      size_t count(size_t coil) const { return sensors ? sensors[coil].numberOfAxes : 1; }
+      const Coordinate* axes(size_t coil) const { return sensors ? sensors[coil].axes.data() : directions + coil; }
+    };
+    
+    static std::vector<Coordinate> sensorPositions(const std::vector<MultiAxisSensor<FieldType>>& sensors)
+    {
+      std::vector<Coordinate> positions(sensors.size());
+      for(size_t i = 0; i < sensors.size(); ++i) {
+        positions[i] = sensors[i].position;
+      }
+      return positions;
+    }
+    
+    template<class DipolePositions>
+    std::vector<FieldType> leadField(const DipolePositions& dipolePositions, const std::vector<Coordinate>& coilPositions,
+                                     const CoilAxes& coilAxes, size_t numberOfThreads,
+                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms, size_t numberOfBatches = 1) const
+    {
+      return assembleLeadField<dim>(dipolePositions, coilPositions, coilAxes, numberOfThreads, totalFieldKernel(), channelTransforms, numberOfBatches);
+    }
+    
+    template<class DipolePositions>
+    std::vector<FieldType> primaryLeadField(const DipolePositions& dipolePositions, const std::vector<Coordinate>& coilPositions,
+                                            const CoilAxes& coilAxes, size_t numberOfThreads,
+                                            const std::vector<ChannelTransform<FieldType>>& channelTransforms) const
+    {
+      return assembleLeadField<dim>(dipolePositions, coilPositions, coilAxes, numberOfThreads,
+        [&](size_t, const Coordinate& dipolePos, const Coordinate& R, const Coordinate* directions, size_t numberOfAxes, FieldType* entry, size_t rowStride) {
+          for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+            Coordinate columns = primaryFieldLeadFieldColumns(dipolePos, R, directions[axis]);
+            std::copy(columns.begin(), columns.end(), entry + axis * rowStride);
+          }
+        }, channelTransforms);
+    }
+    
+    template<class DipolePositions>
+    std::vector<FieldType> secondaryLeadField(const DipolePositions& dipolePositions, const std::vector<Coordinate>& coilPositions,
+                                              const CoilAxes& coilAxes, size_t numberOfThreads,
+                                              const std::vector<ChannelTransform<FieldType>>& channelTransforms) const
+    {
+      return assembleLeadField<dim>(dipolePositions, coilPositions, coilAxes, numberOfThreads,
+        [&](size_t, const Coordinate& dipolePos, const Coordinate& R, const Coordinate* directions, size_t numberOfAxes, FieldType* entry, size_t rowStride) {
+          for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+            Coordinate columns = primaryFieldLeadFieldColumns(dipolePos, R, directions[axis]) - totalFieldLeadFieldColumns(dipolePos, R, directions[axis]);
+            std::copy(columns.begin(), columns.end(), entry + axis * rowStride);
+          }
+        }, channelTransforms);
+    }
+    
+    // leading rows of assembleLeadField if there are none
+    struct NoLeadingRows {
+      void operator()(size_t, size_t, const Coordinate*, FieldType*, size_t) const {}
+    };
+    
+    // kernel of assembleLeadField for the total field
+    auto totalFieldKernel() const
+    {
+      return [this](size_t, const Coordinate& dipolePos, const Coordinate& R, const Coordinate* directions, size_t numberOfAxes, FieldType* entry, size_t rowStride) {
+        FieldType F;
+        Coordinate grad_F;
+        sarvasGeometry(dipolePos, R, F, grad_F);
+        Coordinate dipolePosCrossR = crossProduct(dipolePos, R);
+        FieldType scale = scalingFactor_ / (F * F);
+        for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+          Coordinate columns = F * crossProduct(dipolePos, directions[axis]);
+          columns.axpy(-(grad_F * directions[axis]), dipolePosCrossR);
+          columns *= scale;
+          std::copy(columns.begin(), columns.end(), entry + axis * rowStride);
+        }
+      };
+    }
+    
+    std::vector<FieldType> tangentialLeadField(const std::vector<Coordinate>& dipolePositions, const std::vector<Coordinate>& coilPositions,
+                                               const CoilAxes& coilAxes, size_t numberOfThreads,
+                                               const std::vector<ChannelTransform<FieldType>>& channelTransforms) const
+    {
+      std::vector<std::array<Coordinate, 2>> bases(dipolePositions.size());
+      for(size_t i = 0; i < dipolePositions.size(); ++i) {
+        bases[i] = tangentialBasis(dipolePositions[i]);
+      }
+      return assembleLeadField<2>(dipolePositions, coilPositions, coilAxes, numberOfThreads,
+        [&](size_t i, const Coordinate& dipolePos, const Coordinate& R, const Coordinate* directions, size_t numberOfAxes, FieldType* entry, size_t rowStride) {
+          FieldType F;
+          Coordinate grad_F;
+          sarvasGeometry(dipolePos, R, F, grad_F);
+          FieldType scale = scalingFactor_ * dipolePos.two_norm() / (F * F);
+          const auto& basis = bases[i];
+          FieldType t1TimesR = basis[0] * R;
+          FieldType t2TimesR = basis[1] * R;
+          for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+            FieldType gradFTimesD = grad_F * directions[axis];
+            entry[axis * rowStride] = scale * (t2TimesR * gradFTimesD - F * (basis[1] * directions[axis]));
+            entry[axis * rowStride + 1] = scale * (F * (basis[0] * directions[axis]) - t1TimesR * gradFTimesD);
+          }
+        }, channelTransforms);
+    }
+    
+    std::vector<FieldType> fixedOrientationLeadField(const std::vector<Coordinate>& dipolePositions,
+                                                     const std::vector<Coordinate>& dipoleOrientations,
+                                                     const std::vector<Coordinate>& coilPositions,
+                                                     const CoilAxes& coilAxes, size_t numberOfThreads,
+                                                     const std::vector<ChannelTransform<FieldType>>& channelTransforms) const
+    {
+      if(dipolePositions.size() != dipoleOrientations.size()) {
+        throw std::invalid_argument("number of dipole positions and number of dipole orientations differ");
+      }
+      std::vector<Coordinate> q(dipolePositions.size());
+      for(size_t i = 0; i < dipolePositions.size(); ++i) {
+        q[i] = crossProduct(dipoleOrientations[i], dipolePositions[i] - sphereCenter_);
+      }
+      return assembleLeadField<1>(dipolePositions, coilPositions, coilAxes, numberOfThreads,
+        [&](size_t i, const Coordinate& dipolePos, const Coordinate& R, const Coordinate* directions, size_t numberOfAxes, FieldType* entry, size_t rowStride) {
+          FieldType F;
+          Coordinate grad_F;
+          sarvasGeometry(dipolePos, R, F, grad_F);
+          FieldType scale = scalingFactor_ / (F * F);
+          FieldType qTimesR = q[i] * R;
+          for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+            entry[axis * rowStride] = scale * (F * (q[i] * directions[axis]) - qTimesR * (grad_F * directions[axis]));
+          }
+        }, channelTransforms);
+    }
+    
+    // the first quadrature point of every patch serves as its position in assembleLeadField, the other points being given by their
+    // offsets to it, such that the kernel receives them relative to the sphere center
+    std::vector<FieldType> patchLeadField(const PatchQuadrature<FieldType>& patches, const std::vector<Coordinate>& coilPositions,
+                                          const CoilAxes& coilAxes, size_t numberOfThreads,
+                                          const std::vector<ChannelTransform<FieldType>>& channelTransforms) const
+    {
+      if(patches.positions.size() != patches.moments.size() || patches.offsets.empty() || patches.offsets.back() != patches.positions.size()) {
+        throw std::invalid_argument("inconsistent patch quadrature");
+      }
+      const size_t numberOfPatches = patches.numberOfPatches();
+      std::vector<Coordinate> references(numberOfPatches, sphereCenter_);
+      std::vector<Coordinate> offsets(patches.positions.size());
+      for(size_t p = 0; p < numberOfPatches; ++p) {
+        if(patches.offsets[p] < patches.offsets[p + 1]) {
+          references[p] = patches.positions[patches.offsets[p]];
+        }
+        for(size_t j = patches.offsets[p]; j < patches.offsets[p + 1]; ++j) {
+          offsets[j] = patches.positions[j] - references[p];
+        }
+      }
+      return assembleLeadField<1>(references, coilPositions, coilAxes, numberOfThreads,
+        [&](size_t i, const Coordinate& dipolePos, const Coordinate& R, const Coordinate* directions, size_t numberOfAxes, FieldType* entry, size_t rowStride) {
+          std::array<FieldType, MultiAxisSensor<FieldType>::maximumNumberOfAxes> sums = {};
+          for(size_t j = patches.offsets[i]; j < patches.offsets[i + 1]; ++j) {
+            Coordinate position = dipolePos + offsets[j];
+            FieldType F;
+            Coordinate grad_F;
+            sarvasGeometry(position, R, F, grad_F);
+            Coordinate q = crossProduct(patches.moments[j], position);
+            FieldType scale = scalingFactor_ / (F * F);
+            FieldType qTimesR = q * R;
+            for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+              sums[axis] += scale * (F * (q * directions[axis]) - qTimesR * (grad_F * directions[axis]));
+            }
+          }
+          for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+            entry[axis * rowStride] = sums[axis];
+          }
+        }, channelTransforms);
+    }
+    
+    // assemble a lead field with columnsPerDipole columns per dipole position and one row per coil axis, where
+    // kernel(i, dipolePos, R, directions, numberOfAxes, entry, rowStride) writes the columns of dipole position i at dipolePos for
+    // the coil at R, both given relative to the sphere center of the coil, with the given axes into the rows entry,
+    // entry + rowStride, ... The coils are walked in groups sharing a sphere center, a single group unless coilAxes has local
+    // sphere centers, and the dipole positions of a block are taken relative to the center once per group. The coil positions may
+    // contain numberOfBatches sets of coils of equal size with the same numbers of axes one after another, e.g. the coils of
+    // several head poses, in which case the result contains the lead fields of all sets one after another. The pairs of coil set
+    // and block of dipole positions are distributed over numberOfThreads threads, where 0 means one thread per hardware thread.
+    // Every thread computes the columns of its block for all coils of the set into a small tile, which is then copied into the
+    // result.
+    //
+    // If channelTransforms is not empty, the transforms are composed into one operator once, which is applied to every tile while
+    // it is still in cache, so that every set of coils yields #outputChannels rows and the raw lead field is never stored.
+    //
+    // If numberOfLeadingRows is positive, every set starts with that many rows written by
+    // leadingRows(blockBegin, blockEnd, dipolePos, tile, rowStride) with the positions of the block relative to the center of the
+    // first group of coils, see leadFieldWithLeadingRows.
+    template<size_t columnsPerDipole, class DipolePositions, class Kernel, class LeadingRows = NoLeadingRows>
+    std::vector<FieldType> assembleLeadField(const DipolePositions& dipolePositions,
+                                             const std::vector<Coordinate>& coilPositions,
+                                             const CoilAxes& coilAxes,
+                                             size_t numberOfThreads, Kernel kernel,
+                                             const std::vector<ChannelTransform<FieldType>>& channelTransforms,
+                                             size_t numberOfBatches = 1, size_t numberOfLeadingRows = 0,
+                                             LeadingRows leadingRows = {}) const
+    {
+      const size_t numberOfCoils = numberOfBatches > 0 ? coilPositions.size() / numberOfBatches : 0;
+      // first row of every coil within a set
+      std::vector<size_t> rowOffsets(numberOfCoils + 1, numberOfLeadingRows);
+      for(size_t coil = 0; coil < numberOfCoils; ++coil) {
+        rowOffsets[coil + 1] = rowOffsets[coil] + coilAxes.count(coil);
+      }
+      const size_t numberOfRows = rowOffsets[numberOfCoils];
+      std::unique_ptr<ChannelTransform<FieldType>> channelTransform;
+      if(!channelTransforms.empty()) {
+        channelTransform = std::make_unique<ChannelTransform<FieldType>>(ChannelTransform<FieldType>::compose(channelTransforms));
+        if(channelTransform->numberOfInputChannels() != numberOfRows) {
+          throw std::invalid_argument("number of input channels of the channel transforms differs from the number of coil axes");
+        }
+      }
+      const size_t numberOfOutputRows = channelTransform ? channelTransform->numberOfOutputChannels() : numberOfRows;
+      const size_t numberOfColumns = columnsPerDipole * dipolePositions.size();
+      std::vector<FieldType> result(numberOfBatches * numberOfOutputRows * numberOfColumns);
+      
+      // coils of a set ordered by sphere center, with groupOffsets[g] the first coil of group g in this order
+      std::vector<size_t> coilOrder(numberOfCoils);
+      for(size_t coil = 0; coil < numberOfCoils; ++coil) {
+        coilOrder[coil] = coil;
+      }
+      std::vector<size_t> groupOffsets(1, 0);
+      if(coilAxes.centers) {
+        auto less = [&](size_t a, size_t b) {
+          return std::lexicographical_compare(coilAxes.centers[a].begin(), coilAxes.centers[a].end(), coilAxes.centers[b].begin(), coilAxes.centers[b].end());
+        };
+        std::stable_sort(coilOrder.begin(), coilOrder.end(), less);
+        for(size_t k = 1; k < numberOfCoils; ++k) {
+          if(less(coilOrder[k - 1], coilOrder[k])) {
+            groupOffsets.push_back(k);
+          }
+        }
+      }
+      groupOffsets.push_back(numberOfCoils);
+      
+      instrumentation_.countEvaluations(InstrumentedMethod::leadField, numberOfBatches * numberOfCoils * dipolePositions.size());
+      
+      // one tile of #rows x (columnsPerDipole * leadFieldBlockSize) entries per thread, and one for the transformed channels
+      std::vector<std::vector<FieldType>> tiles(resolveNumberOfThreads(numberOfThreads));
+      std::vector<std::vector<FieldType>> transformedTiles(channelTransform ? tiles.size() : 0);
+      const size_t blocksPerBatch = (dipolePositions.size() + leadFieldBlockSize - 1) / leadFieldBlockSize;
+      
+      auto regionStart = instrumentation_.now();
+      size_t threadsUsed = parallelForBlocks(numberOfBatches * blocksPerBatch, 1, numberOfThreads, [&](size_t itemBegin, size_t itemEnd, size_t threadIndex) {
+        auto busyTimer = instrumentation_.busyTimer();
+        for(size_t item = itemBegin; item < itemEnd; ++item) {
+          const size_t batch = item / blocksPerBatch;
+          const size_t blockBegin = (item % blocksPerBatch) * leadFieldBlockSize;
+          const size_t blockEnd = std::min(blockBegin + leadFieldBlockSize, dipolePositions.size());
+          const size_t tileColumns = columnsPerDipole * (blockEnd - blockBegin);
+          auto& tile = tiles[threadIndex];
+          tile.resize(numberOfRows * tileColumns);
+          
+          {
+            TraceSpan kernelSpan("kernel", "leadField");
+            auto kernelTimer = instrumentation_.timer(InstrumentedPhase::kernel);
+            std::array<Coordinate, leadFieldBlockSize> dipolePos;
+            for(size_t group = 0; group + 1 < groupOffsets.size(); ++group) {
+              const Coordinate& center = coilAxes.centers ? coilAxes.centers[coilOrder[groupOffsets[group]]] : sphereCenter_;
+              for(size_t i = blockBegin; i < blockEnd; ++i) {
+                dipolePos[i - blockBegin] = dipolePositions[i] - center;
+              }
+              if(numberOfLeadingRows > 0 && group == 0) {
+                leadingRows(blockBegin, blockEnd, dipolePos.data(), tile.data(), tileColumns);
+              }
+              for(size_t k = groupOffsets[group]; k < groupOffsets[group + 1]; ++k) {
+                const size_t coil = coilOrder[k];
+                const size_t batchCoil = batch * numberOfCoils + coil;
+                Coordinate R = coilPositions[batchCoil] - center;
+                const Coordinate* directions = coilAxes.axes(batchCoil);
+                const size_t numberOfAxes = coilAxes.count(batchCoil);
+                FieldType* tileRow = tile.data() + rowOffsets[coil] * tileColumns;
+                for(size_t i = blockBegin; i < blockEnd; ++i) {
+                  kernel(i, dipolePos[i - blockBegin], R, directions, numberOfAxes, tileRow + columnsPerDipole * (i - blockBegin), tileColumns);
+                }
+              }
+            }
+          }
+          
+          const FieldType* outputTile = tile.data();
+          if(channelTransform) {
+            TraceSpan transformSpan("transform", "leadField");
+            auto transformTimer = instrumentation_.timer(InstrumentedPhase::transform);
+            auto& transformedTile = transformedTiles[threadIndex];
+            transformedTile.resize(numberOfOutputRows * tileColumns);
+            channelTransform->apply(tile.data(), tileColumns, transformedTile.data());
+            outputTile = transformedTile.data();
+          }
+          
+          TraceSpan writeSpan("write", "leadField");
+          auto reductionTimer = instrumentation_.timer(InstrumentedPhase::reduction);
+          FieldType* batchResult = result.data() + batch * numberOfOutputRows * numberOfColumns;
+          for(size_t row = 0; row < numberOfOutputRows; ++row) {
+            std::copy_n(outputTile + row * tileColumns, tileColumns, batchResult + row * numberOfColumns + columnsPerDipole * blockBegin);
+          }
+        }
+      });
+      instrumentation_.recordParallelRegion(regionStart, threadsUsed);
+      
+      return result;
+    }
+    
+    // projections of the total fields of unit dipoles at dipolePos in x-, y- and z-direction onto direction. Both positions have to be
+    // given relative to the sphere center.
+    Coordinate totalFieldLeadFieldColumns(const Coordinate& dipolePos, const Coordinate& R, const Coordinate& direction) const
+    {
+      FieldType F;
+      Coordinate grad_F;
+      sarvasGeometry(dipolePos, R, F, grad_F);
+      
+      Coordinate columns = F * crossProduct(dipolePos, direction);
+      columns.axpy(-(grad_F * direction), crossProduct(dipolePos, R));
+      columns *= scalingFactor_ / (F * F);
+      return columns;
+    }
+    
+    // projections of the primary fields of unit dipoles at dipolePos in x-, y- and z-direction onto direction
+    Coordinate primaryFieldLeadFieldColumns(const Coordinate& dipolePos, const Coordinate& R, const Coordinate& direction) const
+    {
+      Coordinate diff = R - dipolePos;
+      FieldType diffNorm = diff.two_norm();
+      instrumentation_.checkNearSingular(diffNorm * diffNorm * diffNorm, R.two_norm());
+      return (scalingFactor_ / (diffNorm * diffNorm * diffNorm)) * crossProduct(diff, direction);
+    }
+    
+    // geometry terms F and grad_F of Sarvas' formula for a dipole at dipolePos and a coil at R, both relative to the sphere center
+    void sarvasGeometry(const Coordinate& dipolePos, const Coordinate& R, FieldType& F, Coordinate& grad_F) const
+    {
+      Coordinate A = R - dipolePos;
+      FieldType r = R.two_norm();
+      FieldType a = A.two_norm();
+      
+      F = a * (r * a + r * r - dipolePos * R);
+      instrumentation_.checkNearSingular(F, r);
+      
+      grad_F = (a*a/r + A * R/a + 2*(a + r)) * R - (a + 2*r + A * R/a)* dipolePos;
+    }
+    
+    template<class T>
+    static void checkSameSize(const std::vector<Coordinate>& positions, const std::vector<T>& directions)
+    {
+      if(positions.size() != directions.size()) {
+        throw std::invalid_argument("number of coil positions and number of coil directions differ");
+      }
+    }
+    
   }; // end class AnalyticSolutionMEG 
+  
+  // implements the analytic EEG forward solution for multilayer sphere models in 3 dimensions, i.e. the electric potential at the
+  // outer surface of concentric spheres with layer wise isotropic conductivity, see
+  // J.C. de Munck, M.J. Peters, A fast method to compute the potential in the multisphere model, 1993.
+  // The dipoles have to lie in the innermost layer, the electrodes are projected onto the outer sphere, and the potential is
+  // given with respect to infinity.
+  //
+  // For a dipole at r_0 and an electrode in direction e on the outer sphere of radius r_L, the potential is given by
+  // 1 / (4 pi sigma_1 r_L^2) * sum_n h_n t^(n-1) (n P_n(x) (q * u) + P_n'(x) (q * e - x (q * u))), where t = |r_0| / r_L,
+  // u = r_0 / |r_0| and x = u * e. The coefficients h_n only depend on the layers and are precomputed in the constructor. For
+  // large n they approach hInfinity + hOne / n, whose series are summed in closed form, so that only the remainder, which
+  // decays like t^n / n^2, is summed explicitly with as many terms as the eccentricity of the dipole requires.
+  template<class FieldType>
+  class AnalyticSolutionEEG
+  {
+  public:
+    static constexpr size_t dim = 3;
+    using Coordinate = Dune::FieldVector<FieldType, dim>;
+    
+    // constructor, taking the radii of the layers from the innermost to the outermost and their conductivities. The series is
+    // truncated as soon as the remaining terms are below tolerance relative to the leading term. The evaluation throws for dipoles
+    // so close to the outer sphere that more than maximumOrder terms would be needed. Throws if the radii are not positive and
+    // increasing or the conductivities are not positive.
+    AnalyticSolutionEEG(const Coordinate& sphereCenter, const std::vector<FieldType>& radii, const std::vector<FieldType>& conductivities,
+                        FieldType tolerance = 1e-10, size_t maximumOrder = 1000)
+      : sphereCenter_(sphereCenter)
+      , radii_(radii)
+      , conductivities_(conductivities)
+      , tolerance_(tolerance)
+      , maximumOrder_(std::max<size_t>(maximumOrder, 1))
+    {
+      if(radii_.empty() || radii_.size() != conductivities_.size()) {
+        throw std::invalid_argument("number of radii and number of conductivities differ or are zero");
+      }
+      for(size_t layer = 0; layer < radii_.size(); ++layer) {
+        if(radii_[layer] <= 0.0 || (layer > 0 && radii_[layer] <= radii_[layer - 1])) {
+          throw std::invalid_argument("radii have to be positive and increasing");
+        }
+        if(conductivities_[layer] <= 0.0) {
+          throw std::invalid_argument("conductivities have to be positive");
+        }
+      }
+      computeSeriesCoefficients();
+    }
+    
+    const Coordinate& sphereCenter() const
+    {
+      return sphereCenter_;
+    }
+    
+    const std::vector<FieldType>& radii() const
+    {
+      return radii_;
+    }
+    
+    const std::vector<FieldType>& conductivities() const
+    {
+      return conductivities_;
+    }
+    
+    size_t maximumOrder() const
+    {
+      return maximumOrder_;
+    }
+    
+    // coefficient h_n of the series for 1 <= n <= maximumOrder
+    FieldType seriesCoefficient(size_t n) const
+    {
+      return remainders_[n - 1] + hInfinity_ + hOne_ / n;
+    }
+    
+    // throws if the dipole is not inside the innermost layer
+    void bind(const Dipole<FieldType, dim>& dipole)
+    {
+      R_0 = dipole.position() - sphereCenter_;
+      checkInnermostLayer(R_0);
+      moment_ = dipole.moment();
+    }
+    
+    // number of explicitly summed terms of the series for a dipole at the given position. Throws if the tolerance is not
+    // reached within maximumOrder terms, as do all methods evaluating the series for such a dipole.
+    size_t numberOfTerms(const Coordinate& dipolePosition) const
+    {
+      return seriesLength((dipolePosition - sphereCenter_).two_norm() / radii_.back());
+    }
+    
+    //////////////////////////////////
+    // potential of the bound dipole
+    //////////////////////////////////
+    
+    FieldType potential(const Coordinate& electrodePos) const
+    {
+      Coordinate direction = electrodeDirection(electrodePos);
+      Coordinate column;
+      seriesColumns(R_0, &direction, 1, &column);
+      return column * moment_;
+    }
+    
+    std::vector<FieldType> potential(const std::vector<Coordinate>& electrodePositions) const
+    {
+      std::vector<FieldType> potentials(electrodePositions.size());
+      std::array<Coordinate, electrodeBlockSize> directions;
+      std::array<Coordinate, electrodeBlockSize> columns;
+      for(size_t blockBegin = 0; blockBegin < electrodePositions.size(); blockBegin += electrodeBlockSize) {
+        const size_t count = std::min(electrodeBlockSize, electrodePositions.size() - blockBegin);
+        for(size_t k = 0; k < count; ++k) {
+          directions[k] = electrodeDirection(electrodePositions[blockBegin + k]);
+        }
+        seriesColumns(R_0, directions.data(), count, columns.data());
+        for(size_t k = 0; k < count; ++k) {
+          potentials[blockBegin + k] = columns[k] * moment_;
+        }
+      }
+      return potentials;
+    }
+    
+    //////////////////////////////////
+    // lead field computation
+    //////////////////////////////////
+    
+    // compute the lead field of the potential for the given dipole positions and electrodes. The result is a row major matrix of
+    // size #electrodes x (3 * #dipolePositions), where the columns 3 * i, 3 * i + 1 and 3 * i + 2 contain the potentials of unit
+    // dipoles at dipolePositions[i] pointing in x-, y- and z-direction. The dipole positions are distributed in blocks over
+    // numberOfThreads threads, where 0 means one thread per hardware thread. Throws if a dipole position is not inside the
+    // innermost layer.
+    std::vector<FieldType> leadField(const std::vector<Coordinate>& dipolePositions,
+                                     const std::vector<Coordinate>& electrodePositions,
+                                     size_t numberOfThreads = 0) const
+    {
+      TraceSpan span("eegLeadField", "job");
+      std::vector<Coordinate> dipolePos(dipolePositions.size());
+      for(size_t i = 0; i < dipolePositions.size(); ++i) {
+        dipolePos[i] = dipolePositions[i] - sphereCenter_;
+        checkInnermostLayer(dipolePos[i]);
+      }
+      std::vector<Coordinate> directions(electrodePositions.size());
+      for(size_t k = 0; k < electrodePositions.size(); ++k) {
+        directions[k] = electrodeDirection(electrodePositions[k]);
+      }
+      
+      const size_t numberOfColumns = dim * dipolePositions.size();
+      std::vector<FieldType> result(electrodePositions.size() * numberOfColumns);
+      parallelForBlocks(dipolePositions.size(), leadFieldBlockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        TraceSpan kernelSpan("kernel", "eegLeadField");
+        std::array<Coordinate, electrodeBlockSize> columns;
+        for(size_t electrodeBegin = 0; electrodeBegin < directions.size(); electrodeBegin += electrodeBlockSize) {
+          const size_t count = std::min(electrodeBlockSize, directions.size() - electrodeBegin);
+          for(size_t i = blockBegin; i < blockEnd; ++i) {
+            seriesColumns(dipolePos[i], directions.data() + electrodeBegin, count, columns.data());
+            for(size_t k = 0; k < count; ++k) {
+              std::copy(columns[k].begin(), columns[k].end(), result.begin() + (electrodeBegin + k) * numberOfColumns + dim * i);
+            }
+          }
+        }
+      });
+      return result;
+    }
+    
+    // compute rows of the lead field for one dipole position, i.e. the potentials of unit dipoles at dipolePosition in x-, y- and
+    // z-direction at count electrodes given by their directions from electrodeDirection, without binding a dipole. Throws if the
+    // dipole position is not inside the innermost layer.
+    void leadFieldColumns(const Coordinate& dipolePosition, const Coordinate* electrodeDirections, size_t count, Coordinate* columns) const
+    {
+      centeredLeadFieldColumns(dipolePosition - sphereCenter_, electrodeDirections, count, columns);
+    }
+    
+    // compute the rows of leadFieldColumns for a dipole position given relative to the sphere center, e.g. by a lead field builder
+    // which has already centered the positions. Throws if the dipole position is not inside the innermost layer.
+    void centeredLeadFieldColumns(const Coordinate& dipolePos, const Coordinate* electrodeDirections, size_t count, Coordinate* columns) const
+    {
+      checkInnermostLayer(dipolePos);
+      for(size_t blockBegin = 0; blockBegin < count; blockBegin += electrodeBlockSize) {
+        seriesColumns(dipolePos, electrodeDirections + blockBegin, std::min(electrodeBlockSize, count - blockBegin), columns + blockBegin);
+      }
+    }
+    
+    // unit direction from the sphere center to the electrode, i.e. the electrode projected onto the outer sphere
+    Coordinate electrodeDirection(const Coordinate& electrodePos) const
+    {
+      Coordinate direction = electrodePos - sphereCenter_;
+      FieldType norm = direction.two_norm();
+      if(norm == 0.0) {
+        throw std::invalid_argument("electrode at the sphere center");
+      }
+      direction /= norm;
+      return direction;
+    }
+    
+  private:
+    //set in constructor
+    Coordinate sphereCenter_;
+    std::vector<FieldType> radii_;
+    std::vector<FieldType> conductivities_;
+    FieldType tolerance_;
+    size_t maximumOrder_;
+    
+    // limit of the coefficients h_n and of n (h_n - hInfinity_)
+    FieldType hInfinity_;
+    FieldType hOne_;
+    // remainders h_n - hInfinity_ - hOne_ / n for n = 1, ..., maximumOrder_ at index n - 1
+    std::vector<FieldType> remainders_;
+    // tailBounds_[n] bounds the size of the terms of order larger than n, relative to t^n
+    std::vector<FieldType> tailBounds_;
+    
+    // set later on
+    Coordinate moment_;
+    Coordinate R_0;
+    
+    // number of dipole positions a thread processes at once during lead field computation
+    static constexpr size_t leadFieldBlockSize = 16;
+    // number of electrodes whose Legendre recurrences are run side by side
+    static constexpr size_t electrodeBlockSize = 64;
+    
+    // Compute h_n by propagating the coefficients of r^n and r^(-n-1) of the potential from the outer boundary, where the
+    // normal current vanishes, through the interfaces, where potential and normal current are continuous, to the innermost layer,
+    // where the coefficient of r^(-n-1) is fixed by the source. We track the values x = A r^n and y = B r^(-n-1) at the interfaces
+    // and drop the common factor (r_1 / r_L)^(n+1), such that x decays by (r_inner / r_outer)^(2n+1) within a layer and nothing
+    // overflows for large n.
+    void computeSeriesCoefficients()
+    {
+      const size_t numberOfLayers = radii_.size();
+      remainders_.resize(maximumOrder_);
+      std::vector<FieldType> coefficients(maximumOrder_);
+      for(size_t n = 1; n <= maximumOrder_; ++n) {
+        FieldType x = n + 1.0;
+        FieldType y = n;
+        for(size_t layer = numberOfLayers - 1; layer > 0; --layer) {
+          x *= std::pow(radii_[layer - 1] / radii_[layer], 2.0 * n + 1.0);
+          FieldType S = x + y;
+          FieldType T = conductivities_[layer] / conductivities_[layer - 1] * (n * x - (n + 1.0) * y);
+          x = (T + (n + 1.0) * S) / (2.0 * n + 1.0);
+          y = (n * S - T) / (2.0 * n + 1.0);
+        }
+        coefficients[n - 1] = (2.0 * n + 1.0) / y;
+      }
+      
+      // h_n approaches (2n + 1) / n * prod_j (2n + 1) / (n + (n + 1) s_j) for the conductivity ratios s_j of the interfaces
+      hInfinity_ = 2.0;
+      FieldType logarithmicDerivative = 0.5;
+      for(size_t layer = 1; layer < numberOfLayers; ++layer) {
+        FieldType s = conductivities_[layer] / conductivities_[layer - 1];
+        hInfinity_ *= 2.0 / (1.0 + s);
+        logarithmicDerivative += 0.5 * (1.0 - s) / (1.0 + s);
+      }
+      hOne_ = hInfinity_ * logarithmicDerivative;
+      
+      tailBounds_.assign(maximumOrder_ + 1, 0.0);
+      for(size_t n = maximumOrder_; n >= 1; --n) {
+        remainders_[n - 1] = coefficients[n - 1] - hInfinity_ - hOne_ / n;
+        // |n P_n - x P_n'| and |P_n'| are bounded by n (n + 1)
+        FieldType bound = std::abs(remainders_[n - 1]) * n * (n + 1.0);
+        tailBounds_[n - 1] = std::max(tailBounds_[n], bound);
+      }
+    }
+    
+    // smallest number of terms such that the remaining terms, of size at most tailBounds_[N] t^N / (1 - t), are below tolerance
+    // relative to the closed form part. Throws if more than maximumOrder_ terms would be needed, since the terms beyond it are
+    // neither summed nor bounded, i.e. the tolerance could not be guaranteed.
+    size_t seriesLength(FieldType t) const
+    {
+      FieldType threshold = tolerance_ * hInfinity_ * (1.0 - t);
+      size_t N = 0;
+      FieldType tPower = 1.0;
+      while(tailBounds_[N] * tPower > threshold) {
+        if(N + 1 == maximumOrder_) {
+          throw std::runtime_error("the EEG series does not reach the tolerance within the maximum order for a dipole at "
+                                   "eccentricity " + std::to_string(t) + ", increase the maximum order or the tolerance");
+        }
+        ++N;
+        tPower *= t;
+      }
+      return N;
+    }
+    
+    // potentials of unit dipoles at dipolePos, relative to the sphere center, in x-, y- and z-direction at count <= electrodeBlockSize
+    // electrodes in the given unit directions
+    void seriesColumns(const Coordinate& dipolePos, const Coordinate* directions, size_t count, Coordinate* columns) const
+    {
+      const FieldType outerRadius = radii_.back();
+      const FieldType r0 = dipolePos.two_norm();
+      const FieldType t = r0 / outerRadius;
+      Coordinate u = dipolePos;
+      if(r0 > 0.0) {
+        u /= r0;
+      }
+      else {
+        u = {0.0, 0.0, 1.0};
+      }
+      const FieldType scale = 1.0 / (4.0 * M_PI * conductivities_.front() * outerRadius * outerRadius);
+      
+      // closed form sums of the asymptotic coefficients, with
+      // sum_n t^(n-1) (...) = r_L^2 (r_e - r_0) / d^3 and sum_n t^(n-1) / n (...) = (e + (r_e - r_0) / d) / (1 - x t + d / r_L)
+      std::array<FieldType, electrodeBlockSize> x;
+      for(size_t k = 0; k < count; ++k) {
+        x[k] = u * directions[k];
+        Coordinate difference = outerRadius * directions[k] - dipolePos;
+        FieldType d = difference.two_norm();
+        FieldType denominator = 1.0 - x[k] * t + d / outerRadius;
+        columns[k] = (hInfinity_ * outerRadius * outerRadius / (d * d * d) + hOne_ / (d * denominator)) * difference;
+        columns[k].axpy(hOne_ / denominator, directions[k]);
+      }
+      
+      // explicitly summed remainder, with the Legendre recurrences of all electrodes run side by side
+      const size_t N = seriesLength(t);
+      std::array<FieldType, electrodeBlockSize> P, previousP, dP, previousDP, a, b;
+      for(size_t k = 0; k < count; ++k) {
+        previousP[k] = 1.0;
+        P[k] = x[k];
+        previousDP[k] = 0.0;
+        dP[k] = 1.0;
+        a[k] = 0.0;
+        b[k] = 0.0;
+      }
+      FieldType tPower = 1.0;
+      for(size_t n = 1; n <= N; ++n) {
+        const FieldType c = remainders_[n - 1] * tPower;
+        const FieldType nextFactor = (2.0 * n + 1.0) / (n + 1.0);
+        const FieldType previousFactor = n / (n + 1.0);
+        for(size_t k = 0; k < count; ++k) {
+          a[k] += c * (n * P[k] - x[k] * dP[k]);
+          b[k] += c * dP[k];
+          FieldType nextP = nextFactor * x[k] * P[k] - previousFactor * previousP[k];
+          FieldType nextDP = previousDP[k] + (2.0 * n + 1.0) * P[k];
+          previousP[k] = P[k];
+          P[k] = nextP;
+          previousDP[k] = dP[k];
+          dP[k] = nextDP;
+        }
+        tPower *= t;
+      }
+      
+      for(size_t k = 0; k < count; ++k) {
+        columns[k].axpy(a[k], u);
+        columns[k].axpy(b[k], directions[k]);
+        columns[k] *= scale;
+      }
+    }
+    
+    void checkInnermostLayer(const Coordinate& dipolePos) const
+    {
+      if(dipolePos.two_norm() >= radii_.front()) {
+        throw std::invalid_argument("dipole position is not inside the innermost layer");
+      }
+    }
+    
+  }; // end class AnalyticSolutionEEG
 
 } // end namespace duneuro
 #endif // DUNEURO_ANALYTIC_SOLUTION_HH
@@ -0,0 +1,143 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_ERROR_MEASURES_HH
+#define DUNEURO_ANALYTIC_SOLUTION_ERROR_MEASURES_HH
+
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace duneuro {
+
+  // error measures for comparing a numerical solution to the analytic reference solution, where both are given as
+  // vectors of the same size, e.g. the fields of one dipole at all coils
+
+  // error measures of one vector. A vanishing vector, e.g. the MEG field of a dipole at the sphere center or of a radial
+  // dipole, has no topography and no magnitude to compare with, hence
+  //  - if both vectors vanish, they agree and rdm = 0, mag = 1, lnMag = 0 and relativeError = 0,
+  //  - if only the analytic vector vanishes, rdm is NaN, and mag, lnMag and relativeError are +infinity,
+  //  - if only the numerical vector vanishes, rdm is NaN, mag = 0, lnMag = -infinity and relativeError = 1.
+  // Summaries should therefore skip measures that are not finite.
+  template<class FieldType>
+  struct RowErrorMeasures {
+    // relative difference measure RDM = || analytic / ||analytic|| - numerical / ||numerical|| ||, ranging from 0 (same
+    // topography) to 2 (inverted topography)
+    FieldType rdm;
+    // magnitude error MAG = ||numerical|| / ||analytic||, 1 meaning the same magnitude
+    FieldType mag;
+    // logarithmic magnitude error lnMAG = ln(MAG), 0 meaning the same magnitude
+    FieldType lnMag;
+    // relative error ||numerical - analytic|| / ||analytic||
+    FieldType relativeError;
+  };
+
+  // compute all error measures of one vector, which is the single definition of the measures used by the functions below.
+  // The vectors are read twice, once for the norms and the relative error and once for the RDM, which needs the norms.
+  template<class FieldType>
+  RowErrorMeasures<FieldType> rowErrorMeasures(const FieldType* analytic, const FieldType* numerical, size_t size)
+  {
+    FieldType analyticSquared = 0.0;
+    FieldType numericalSquared = 0.0;
+    FieldType differenceSquared = 0.0;
+    for(size_t i = 0; i < size; ++i) {
+      analyticSquared += analytic[i] * analytic[i];
+      numericalSquared += numerical[i] * numerical[i];
+      differenceSquared += (numerical[i] - analytic[i]) * (numerical[i] - analytic[i]);
+    }
+    FieldType analyticNorm = std::sqrt(analyticSquared);
+    FieldType numericalNorm = std::sqrt(numericalSquared);
+
+    RowErrorMeasures<FieldType> measures;
+    if(analyticNorm == 0.0 || numericalNorm == 0.0) {
+      const FieldType infinity = std::numeric_limits<FieldType>::infinity();
+      if(analyticNorm == numericalNorm) {
+        measures = {0.0, 1.0, 0.0, 0.0};
+      }
+      else if(analyticNorm == 0.0) {
+        measures = {std::numeric_limits<FieldType>::quiet_NaN(), infinity, infinity, infinity};
+      }
+      else {
+        measures = {std::numeric_limits<FieldType>::quiet_NaN(), 0.0, -infinity, 1.0};
+      }
+      return measures;
+    }
+
+    FieldType analyticScale = 1.0 / analyticNorm;
+    FieldType numericalScale = 1.0 / numericalNorm;
+    FieldType rdmSquared = 0.0;
+    for(size_t i = 0; i < size; ++i) {
+      FieldType difference = analytic[i] * analyticScale - numerical[i] * numericalScale;
+      rdmSquared += difference * difference;
+    }
+
+    measures.rdm = std::sqrt(rdmSquared);
+    measures.mag = numericalNorm / analyticNorm;
+    measures.lnMag = std::log(measures.mag);
+    measures.relativeError = std::sqrt(differenceSquared) / analyticNorm;
+    return measures;
+  }
+
+  template<class FieldType>
+  FieldType relativeDifferenceMeasure(const FieldType* analytic, const FieldType* numerical, size_t size)
+  {
+    return rowErrorMeasures(analytic, numerical, size).rdm;
+  }
+
+  template<class FieldType>
+  FieldType logMagnitudeError(const FieldType* analytic, const FieldType* numerical, size_t size)
+  {
+    return rowErrorMeasures(analytic, numerical, size).lnMag;
+  }
+
+  template<class FieldType>
+  FieldType magnitudeError(const FieldType* analytic, const FieldType* numerical, size_t size)
+  {
+    return rowErrorMeasures(analytic, numerical, size).mag;
+  }
+
+  template<class FieldType>
+  FieldType relativeError(const FieldType* analytic, const FieldType* numerical, size_t size)
+  {
+    return rowErrorMeasures(analytic, numerical, size).relativeError;
+  }
+
+  // all error measures of the rows of a matrix
+  template<class FieldType>
+  struct ErrorMeasures {
+    std::vector<FieldType> rdm;
+    std::vector<FieldType> mag;
+    std::vector<FieldType> lnMag;
+    std::vector<FieldType> relativeError;
+  };
+
+  // compute RDM, MAG, lnMAG and the relative error for every row of the row major (rows x columns) matrices analytic and
+  // numerical, e.g. one row per dipole and one column per coil. The rows are distributed over numberOfThreads threads, where 0
+  // means one thread per hardware thread.
+  template<class FieldType>
+  ErrorMeasures<FieldType> errorMeasures(const FieldType* analytic, const FieldType* numerical, size_t rows, size_t columns,
+                                         size_t numberOfThreads = 0)
+  {
+    ErrorMeasures<FieldType> measures;
+    measures.rdm.resize(rows);
+    measures.mag.resize(rows);
+    measures.lnMag.resize(rows);
+    measures.relativeError.resize(rows);
+
+    // rows per block, such that a block contains at least a few thousand entries
+    size_t blockSize = std::max<size_t>(1, 4096 / std::max<size_t>(columns, 1));
+    parallelForBlocks(rows, blockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+      for(size_t row = blockBegin; row < blockEnd; ++row) {
+        auto rowMeasures = rowErrorMeasures(analytic + row * columns, numerical + row * columns, columns);
+        measures.rdm[row] = rowMeasures.rdm;
+        measures.mag[row] = rowMeasures.mag;
+        measures.lnMag[row] = rowMeasures.lnMag;
+        measures.relativeError[row] = rowMeasures.relativeError;
+      }
+    });
+
+    return measures;
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_ERROR_MEASURES_HH
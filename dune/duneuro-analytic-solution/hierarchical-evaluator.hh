@@ -0,0 +1,308 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_HIERARCHICAL_EVALUATOR_HH
+#define DUNEURO_ANALYTIC_SOLUTION_HIERARCHICAL_EVALUATOR_HH
+
+#include <duneuro/common/dipole.hh>
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace duneuro {
+
+  // hierarchical evaluation of the summed total field of a large number of dipoles, e.g. a dense cortical current distribution,
+  // at many coils in O((N + S log N) * order^3) instead of O(N * S) operations.
+  //
+  // The dipoles are sorted into an octree. Every box carries order^3 equivalent dipoles at the tensor product Chebyshev nodes
+  // of the box, whose moments are the moments of the dipoles in the box distributed by Lagrange interpolation (for leaves) or
+  // the equivalent moments of the children distributed in the same way (for inner boxes). For a coil outside of the conductor,
+  // Sarvas' formula is smooth in the dipole position away from the coil, so the field of a box seen from a coil with
+  //   half diagonal of the box / distance of the coil from the box center < openingAngle
+  // is well approximated by the field of its equivalent dipoles, with an error decaying roughly like openingAngle^order. All
+  // other boxes are opened, and the dipoles of leaves are summed directly, so that both near and far interactions use the Sarvas
+  // kernel of AnalyticSolutionMEG. Smaller opening angles and higher orders increase accuracy and cost.
+  template<class FieldType>
+  class HierarchicalEvaluatorMEG
+  {
+  public:
+    using Solver = AnalyticSolutionMEG<FieldType>;
+    using Coordinate = typename Solver::Coordinate;
+    static constexpr size_t dim = Solver::dim;
+
+    // build the octree over the dipoles and compute the equivalent dipoles of all boxes, distributing the work over
+    // numberOfThreads threads, where 0 means one thread per hardware thread
+    HierarchicalEvaluatorMEG(const Solver& solver, const std::vector<Dipole<FieldType, dim>>& dipoles, size_t order = 4,
+                             FieldType openingAngle = 0.5, size_t leafSize = 128, size_t numberOfThreads = 0)
+      : solver_(solver)
+      , order_(order)
+      , openingAngle_(openingAngle)
+      , leafSize_(std::max<size_t>(leafSize, 1))
+    {
+      if(order_ < 1) {
+        throw std::invalid_argument("the interpolation order has to be positive");
+      }
+      if(!(openingAngle_ > 0.0 && openingAngle_ < 1.0)) {
+        throw std::invalid_argument("the opening angle has to lie in (0, 1)");
+      }
+      for(size_t j = 0; j < order_; ++j) {
+        chebyshevNodes_.push_back(std::cos(M_PI * (2.0 * j + 1.0) / (2.0 * order_)));
+      }
+      positions_.reserve(dipoles.size());
+      moments_.reserve(dipoles.size());
+      for(const auto& dipole : dipoles) {
+        positions_.push_back(dipole.position());
+        moments_.push_back(dipole.moment());
+      }
+      if(!positions_.empty()) {
+        buildTree();
+        computeEquivalentMoments(numberOfThreads);
+      }
+    }
+
+    // total field of all dipoles at coilPos, projected onto direction
+    FieldType totalField(const Coordinate& coilPos, const Coordinate& direction) const
+    {
+      if(nodes_.empty()) {
+        return 0.0;
+      }
+      const size_t equivalentDipoles = order_ * order_ * order_;
+      FieldType field = 0.0;
+      std::vector<size_t> stack = {0};
+      while(!stack.empty()) {
+        const Node& node = nodes_[stack.back()];
+        size_t nodeIndex = stack.back();
+        stack.pop_back();
+        FieldType distance = (coilPos - node.center).two_norm();
+        bool separated = std::sqrt(FieldType(dim)) * node.halfWidth < openingAngle_ * distance;
+        if(separated && node.end - node.begin > equivalentDipoles) {
+          const Coordinate* moments = equivalentMoments_.data() + nodeIndex * equivalentDipoles;
+          for(size_t k = 0; k < equivalentDipoles; ++k) {
+            field += solver_.leadFieldColumns(equivalentPosition(node, k), coilPos, direction) * moments[k];
+          }
+        }
+        else if(node.numberOfChildren == 0) {
+          for(size_t i = node.begin; i < node.end; ++i) {
+            field += solver_.leadFieldColumns(positions_[i], coilPos, direction) * moments_[i];
+          }
+        }
+        else {
+          for(size_t child = 0; child < node.numberOfChildren; ++child) {
+            stack.push_back(node.firstChild + child);
+          }
+        }
+      }
+      return field;
+    }
+
+    // total fields at all coils, distributing the coils over numberOfThreads threads, where 0 means one thread per hardware
+    // thread
+    std::vector<FieldType> totalField(const std::vector<Coordinate>& coilPositions, const std::vector<Coordinate>& directions,
+                                      size_t numberOfThreads = 0) const
+    {
+      if(coilPositions.size() != directions.size()) {
+        throw std::invalid_argument("number of coil positions and number of coil directions differ");
+      }
+      std::vector<FieldType> fields(coilPositions.size());
+      parallelForBlocks(coilPositions.size(), 4, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        for(size_t coil = blockBegin; coil < blockEnd; ++coil) {
+          fields[coil] = totalField(coilPositions[coil], directions[coil]);
+        }
+      });
+      return fields;
+    }
+
+    size_t numberOfDipoles() const { return positions_.size(); }
+    size_t numberOfNodes() const { return nodes_.size(); }
+    size_t order() const { return order_; }
+    FieldType openingAngle() const { return openingAngle_; }
+
+  private:
+    // a cubic box of the octree, containing the dipoles [begin, end) in tree order. The children of a box are stored
+    // contiguously, and boxes are stored level by level.
+    struct Node {
+      Coordinate center;
+      FieldType halfWidth;
+      size_t begin;
+      size_t end;
+      size_t firstChild;
+      size_t numberOfChildren;
+      size_t depth;
+    };
+
+    // boxes are not split further below this depth, which guards against many coinciding dipoles
+    static constexpr size_t maximumDepth = 24;
+
+    Solver solver_;
+    size_t order_;
+    FieldType openingAngle_;
+    size_t leafSize_;
+    std::vector<FieldType> chebyshevNodes_;
+    // dipoles in tree order
+    std::vector<Coordinate> positions_;
+    std::vector<Coordinate> moments_;
+    std::vector<Node> nodes_;
+    // order^3 equivalent moments per box
+    std::vector<Coordinate> equivalentMoments_;
+
+    // position of the k-th equivalent dipole of a box, where k = (a * order + b) * order + c for the Chebyshev nodes a, b and c
+    Coordinate equivalentPosition(const Node& node, size_t k) const
+    {
+      Coordinate position = {chebyshevNodes_[k / (order_ * order_)], chebyshevNodes_[(k / order_) % order_], chebyshevNodes_[k % order_]};
+      position *= node.halfWidth;
+      position += node.center;
+      return position;
+    }
+
+    // values of the Lagrange polynomials of the Chebyshev nodes at position, per direction
+    void lagrange(const Node& node, const Coordinate& position, std::array<std::vector<FieldType>, dim>& values) const
+    {
+      for(size_t d = 0; d < dim; ++d) {
+        FieldType x = (position[d] - node.center[d]) / node.halfWidth;
+        values[d].assign(order_, 1.0);
+        for(size_t j = 0; j < order_; ++j) {
+          for(size_t k = 0; k < order_; ++k) {
+            if(k != j) {
+              values[d][j] *= (x - chebyshevNodes_[k]) / (chebyshevNodes_[j] - chebyshevNodes_[k]);
+            }
+          }
+        }
+      }
+    }
+
+    // distribute a moment at position onto the equivalent dipoles of node
+    void anterpolate(const Node& node, const Coordinate& position, const Coordinate& moment,
+                     std::array<std::vector<FieldType>, dim>& values, Coordinate* equivalentMoments) const
+    {
+      lagrange(node, position, values);
+      for(size_t a = 0; a < order_; ++a) {
+        for(size_t b = 0; b < order_; ++b) {
+          FieldType weight = values[0][a] * values[1][b];
+          for(size_t c = 0; c < order_; ++c) {
+            equivalentMoments[(a * order_ + b) * order_ + c].axpy(weight * values[2][c], moment);
+          }
+        }
+      }
+    }
+
+    void buildTree()
+    {
+      // cubic bounding box of all dipoles, slightly enlarged
+      Coordinate lower = positions_[0];
+      Coordinate upper = positions_[0];
+      for(const auto& position : positions_) {
+        for(size_t d = 0; d < dim; ++d) {
+          lower[d] = std::min(lower[d], position[d]);
+          upper[d] = std::max(upper[d], position[d]);
+        }
+      }
+      Node root;
+      root.center = lower + upper;
+      root.center *= 0.5;
+      root.halfWidth = 0.0;
+      for(size_t d = 0; d < dim; ++d) {
+        root.halfWidth = std::max(root.halfWidth, 0.5 * (upper[d] - lower[d]));
+      }
+      root.halfWidth = std::max<FieldType>(root.halfWidth * (1.0 + 1e-10), 1e-10);
+      root.begin = 0;
+      root.end = positions_.size();
+      root.numberOfChildren = 0;
+      root.firstChild = 0;
+      root.depth = 0;
+      nodes_.push_back(root);
+
+      // split breadth first, so that the children of every box are stored contiguously and the boxes level by level
+      std::vector<Coordinate> positions(positions_.size());
+      std::vector<Coordinate> moments(moments_.size());
+      for(size_t current = 0; current < nodes_.size(); ++current) {
+        Node node = nodes_[current];
+        if(node.end - node.begin <= leafSize_ || node.depth >= maximumDepth) {
+          continue;
+        }
+
+        // sort the dipoles of the box by octant
+        auto octant = [&](const Coordinate& position) {
+          size_t index = 0;
+          for(size_t d = 0; d < dim; ++d) {
+            index |= (position[d] >= node.center[d] ? 1 : 0) << d;
+          }
+          return index;
+        };
+        std::array<size_t, 9> offsets = {};
+        for(size_t i = node.begin; i < node.end; ++i) {
+          ++offsets[octant(positions_[i]) + 1];
+        }
+        for(size_t o = 0; o < 8; ++o) {
+          offsets[o + 1] += offsets[o];
+        }
+        std::array<size_t, 8> fill;
+        std::copy_n(offsets.begin(), 8, fill.begin());
+        for(size_t i = node.begin; i < node.end; ++i) {
+          size_t target = node.begin + fill[octant(positions_[i])]++;
+          positions[target] = positions_[i];
+          moments[target] = moments_[i];
+        }
+        std::copy(positions.begin() + node.begin, positions.begin() + node.end, positions_.begin() + node.begin);
+        std::copy(moments.begin() + node.begin, moments.begin() + node.end, moments_.begin() + node.begin);
+
+        nodes_[current].firstChild = nodes_.size();
+        for(size_t o = 0; o < 8; ++o) {
+          if(offsets[o + 1] == offsets[o]) {
+            continue;
+          }
+          Node child;
+          child.halfWidth = 0.5 * node.halfWidth;
+          for(size_t d = 0; d < dim; ++d) {
+            child.center[d] = node.center[d] + ((o >> d) & 1 ? child.halfWidth : -child.halfWidth);
+          }
+          child.begin = node.begin + offsets[o];
+          child.end = node.begin + offsets[o + 1];
+          child.firstChild = 0;
+          child.numberOfChildren = 0;
+          child.depth = node.depth + 1;
+          nodes_.push_back(child);
+          ++nodes_[current].numberOfChildren;
+        }
+      }
+    }
+
+    // equivalent moments of all boxes, level by level starting from the deepest one, the boxes of a level in parallel
+    void computeEquivalentMoments(size_t numberOfThreads)
+    {
+      const size_t equivalentDipoles = order_ * order_ * order_;
+      equivalentMoments_.assign(nodes_.size() * equivalentDipoles, Coordinate(0.0));
+
+      size_t levelEnd = nodes_.size();
+      while(levelEnd > 0) {
+        size_t levelBegin = levelEnd;
+        while(levelBegin > 0 && nodes_[levelBegin - 1].depth == nodes_[levelEnd - 1].depth) {
+          --levelBegin;
+        }
+        parallelForBlocks(levelEnd - levelBegin, 1, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+          std::array<std::vector<FieldType>, dim> values;
+          for(size_t n = levelBegin + blockBegin; n < levelBegin + blockEnd; ++n) {
+            const Node& node = nodes_[n];
+            Coordinate* moments = equivalentMoments_.data() + n * equivalentDipoles;
+            if(node.numberOfChildren == 0) {
+              for(size_t i = node.begin; i < node.end; ++i) {
+                anterpolate(node, positions_[i], moments_[i], values, moments);
+              }
+            }
+            else {
+              for(size_t child = node.firstChild; child < node.firstChild + node.numberOfChildren; ++child) {
+                const Coordinate* childMoments = equivalentMoments_.data() + child * equivalentDipoles;
+                for(size_t k = 0; k < equivalentDipoles; ++k) {
+                  anterpolate(node, equivalentPosition(nodes_[child], k), childMoments[k], values, moments);
+                }
+              }
+            }
+          }
+        });
+        levelEnd = levelBegin;
+      }
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_HIERARCHICAL_EVALUATOR_HH
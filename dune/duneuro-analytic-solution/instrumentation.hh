@@ -0,0 +1,236 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION_HH
+#define DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION_HH
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+// set to 1 (e.g. by configuring with -DDUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION=ON) to let the solvers collect
+// evaluation counts and timings. If disabled, all instrumentation calls below are empty and optimized away.
+#ifndef DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION
+#define DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION 0
+#endif
+
+namespace duneuro {
+
+  // the methods whose evaluations are counted. secondaryField is computed from the primary and the total field, hence a call
+  // of secondaryField also counts as one evaluation of primaryField and totalField. One leadField evaluation is one pair of
+  // dipole position and coil, yielding three columns.
+  enum class InstrumentedMethod { totalField, primaryField, secondaryField, leadField };
+  constexpr size_t numberOfInstrumentedMethods = 4;
+
+  // the phases whose wall time is measured
+  //  - bind      : binding a dipole
+  //  - geometry  : computing the geometry terms F and grad_F of Sarvas' formula
+  //  - kernel    : combining the geometry terms with the moment. The lead field fuses geometry and kernel, its blocks are
+  //                accounted for as kernel time
+  //  - reduction : projecting onto coil directions and gathering the results of the batched methods
+  //  - transform : applying the channel transforms (e.g. gradiometers, SSP) to the tiles of the lead field
+  enum class InstrumentedPhase { bind, geometry, kernel, reduction, transform };
+  constexpr size_t numberOfInstrumentedPhases = 5;
+
+  // an evaluation counts as near singular if the geometry term F of Sarvas' formula (or the cubed distance between dipole
+  // and coil for the primary field) is smaller than this tolerance times the cubed distance between coil and sphere center
+  constexpr double nearSingularTolerance = 1e-6;
+
+  // snapshot of the collected counters
+  struct InstrumentationStatistics {
+    bool enabled = false;
+    std::array<uint64_t, numberOfInstrumentedMethods> evaluations = {};
+    std::array<double, numberOfInstrumentedPhases> phaseTimes = {}; // in seconds
+    uint64_t nearSingularHits = 0;
+    uint64_t parallelRegions = 0;
+    double parallelWallTime = 0.0;                                  // in seconds
+    double threadBusyTime = 0.0;                                    // in seconds, summed over all threads
+    double threadCapacityTime = 0.0;                                // in seconds, wall time times number of threads
+
+    // ratio of the time the threads spent working to the time they were available, 1.0 meaning perfect load balance
+    double threadUtilization() const
+    {
+      return threadCapacityTime > 0.0 ? threadBusyTime / threadCapacityTime : 0.0;
+    }
+  };
+
+  template<bool enabled>
+  class BasicInstrumentation;
+
+  // instrumentation which does nothing
+  template<>
+  class BasicInstrumentation<false>
+  {
+  public:
+    // the user provided destructor keeps compilers from warning about unused timers
+    struct ScopedTimer { ~ScopedTimer() {} };
+    struct TimePoint {};
+
+    ScopedTimer timer(InstrumentedPhase) const { return {}; }
+    ScopedTimer busyTimer() const { return {}; }
+    TimePoint now() const { return {}; }
+    void countEvaluations(InstrumentedMethod, uint64_t) const {}
+    template<class FieldType>
+    void checkNearSingular(FieldType, FieldType) const {}
+    void recordParallelRegion(TimePoint, size_t) const {}
+
+    InstrumentationStatistics statistics() const { return {}; }
+    void reset() const {}
+  };
+
+  // instrumentation collecting the counters in atomics, so that it can be used from several threads at once
+  template<>
+  class BasicInstrumentation<true>
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    // adds the lifetime of the object to the given counter of nanoseconds
+    class ScopedTimer
+    {
+    public:
+      explicit ScopedTimer(std::atomic<uint64_t>& nanoseconds)
+        : nanoseconds_(nanoseconds)
+        , start_(Clock::now())
+      {
+      }
+
+      ScopedTimer(const ScopedTimer&) = delete;
+      ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+      ~ScopedTimer()
+      {
+        nanoseconds_ += nanosecondsSince(start_);
+      }
+
+    private:
+      std::atomic<uint64_t>& nanoseconds_;
+      TimePoint start_;
+    };
+
+    BasicInstrumentation()
+    {
+      reset();
+    }
+
+    // the counters are copied, so that a copied solver starts with the statistics of the original one
+    BasicInstrumentation(const BasicInstrumentation& other)
+    {
+      copyFrom(other);
+    }
+
+    BasicInstrumentation& operator=(const BasicInstrumentation& other)
+    {
+      copyFrom(other);
+      return *this;
+    }
+
+    // measures the time of the given phase
+    ScopedTimer timer(InstrumentedPhase phase) const
+    {
+      return ScopedTimer(phaseNanoseconds_[static_cast<size_t>(phase)]);
+    }
+
+    // measures the time a thread spends working inside of a parallel region
+    ScopedTimer busyTimer() const
+    {
+      return ScopedTimer(threadBusyNanoseconds_);
+    }
+
+    TimePoint now() const
+    {
+      return Clock::now();
+    }
+
+    void countEvaluations(InstrumentedMethod method, uint64_t count) const
+    {
+      evaluations_[static_cast<size_t>(method)] += count;
+    }
+
+    // F is the geometry term (or cubed distance), r the distance between coil and sphere center
+    template<class FieldType>
+    void checkNearSingular(FieldType F, FieldType r) const
+    {
+      if(std::abs(F) < nearSingularTolerance * r * r * r) {
+        ++nearSingularHits_;
+      }
+    }
+
+    // record a parallel region which started at the given time and used the given number of threads
+    void recordParallelRegion(TimePoint start, size_t numberOfThreads) const
+    {
+      uint64_t wallNanoseconds = nanosecondsSince(start);
+      ++parallelRegions_;
+      parallelWallNanoseconds_ += wallNanoseconds;
+      threadCapacityNanoseconds_ += wallNanoseconds * numberOfThreads;
+    }
+
+    InstrumentationStatistics statistics() const
+    {
+      InstrumentationStatistics statistics;
+      statistics.enabled = true;
+      for(size_t i = 0; i < numberOfInstrumentedMethods; ++i) {
+        statistics.evaluations[i] = evaluations_[i];
+      }
+      for(size_t i = 0; i < numberOfInstrumentedPhases; ++i) {
+        statistics.phaseTimes[i] = phaseNanoseconds_[i] * 1e-9;
+      }
+      statistics.nearSingularHits = nearSingularHits_;
+      statistics.parallelRegions = parallelRegions_;
+      statistics.parallelWallTime = parallelWallNanoseconds_ * 1e-9;
+      statistics.threadBusyTime = threadBusyNanoseconds_ * 1e-9;
+      statistics.threadCapacityTime = threadCapacityNanoseconds_ * 1e-9;
+      return statistics;
+    }
+
+    void reset() const
+    {
+      for(auto& count : evaluations_) {
+        count = 0;
+      }
+      for(auto& time : phaseNanoseconds_) {
+        time = 0;
+      }
+      nearSingularHits_ = 0;
+      parallelRegions_ = 0;
+      parallelWallNanoseconds_ = 0;
+      threadBusyNanoseconds_ = 0;
+      threadCapacityNanoseconds_ = 0;
+    }
+
+    static uint64_t nanosecondsSince(Clock::time_point start)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+  private:
+    // the counters are mutable, such that const methods of the solvers can be instrumented
+    mutable std::array<std::atomic<uint64_t>, numberOfInstrumentedMethods> evaluations_;
+    mutable std::array<std::atomic<uint64_t>, numberOfInstrumentedPhases> phaseNanoseconds_;
+    mutable std::atomic<uint64_t> nearSingularHits_;
+    mutable std::atomic<uint64_t> parallelRegions_;
+    mutable std::atomic<uint64_t> parallelWallNanoseconds_;
+    mutable std::atomic<uint64_t> threadBusyNanoseconds_;
+    mutable std::atomic<uint64_t> threadCapacityNanoseconds_;
+
+    void copyFrom(const BasicInstrumentation& other)
+    {
+      for(size_t i = 0; i < numberOfInstrumentedMethods; ++i) {
+        evaluations_[i] = other.evaluations_[i].load();
+      }
+      for(size_t i = 0; i < numberOfInstrumentedPhases; ++i) {
+        phaseNanoseconds_[i] = other.phaseNanoseconds_[i].load();
+      }
+      nearSingularHits_ = other.nearSingularHits_.load();
+      parallelRegions_ = other.parallelRegions_.load();
+      parallelWallNanoseconds_ = other.parallelWallNanoseconds_.load();
+      threadBusyNanoseconds_ = other.threadBusyNanoseconds_.load();
+      threadCapacityNanoseconds_ = other.threadCapacityNanoseconds_.load();
+    }
+  };
+
+  using Instrumentation = BasicInstrumentation<DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION != 0>;
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION_HH
@@ -0,0 +1,54 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_JOINT_LEADFIELD_HH
+#define DUNEURO_ANALYTIC_SOLUTION_JOINT_LEADFIELD_HH
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/tracing.hh>
+#include <algorithm>
+#include <vector>
+
+namespace duneuro {
+
+  // compute the EEG and MEG lead fields of one source space in a single pass. The result is a row major matrix of size
+  // (#electrodes + #coils) x (3 * #dipolePositions), whose first #electrodes rows equal eeg.leadField(dipolePositions,
+  // electrodePositions) and whose remaining rows equal meg.leadField(dipolePositions, coilPositions, coilDirections).
+  //
+  // The MEG lead field is assembled by meg.leadFieldWithLeadingRows, which distributes the dipole positions in blocks over
+  // numberOfThreads threads, where 0 means one thread per hardware thread, and centers every block once. The EEG rows of the
+  // block are computed from these centered positions with the series kernel of AnalyticSolutionEEG, shifted if the sphere centers
+  // differ, and validated there once per position, before the MEG rows of the block are computed with the Sarvas kernel into the
+  // same tile. Thus the source space is walked once and every row of the result is written in one contiguous piece per block.
+  template<class FieldType>
+  std::vector<FieldType> jointLeadField(const AnalyticSolutionEEG<FieldType>& eeg, const AnalyticSolutionMEG<FieldType>& meg,
+                                        const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& dipolePositions,
+                                        const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& electrodePositions,
+                                        const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& coilPositions,
+                                        const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& coilDirections,
+                                        size_t numberOfThreads = 0)
+  {
+    using Coordinate = typename AnalyticSolutionMEG<FieldType>::Coordinate;
+    constexpr size_t dim = AnalyticSolutionMEG<FieldType>::dim;
+
+    TraceSpan span("jointLeadField", "job");
+    const size_t numberOfElectrodes = electrodePositions.size();
+    std::vector<Coordinate> electrodeDirections(numberOfElectrodes);
+    for(size_t k = 0; k < numberOfElectrodes; ++k) {
+      electrodeDirections[k] = eeg.electrodeDirection(electrodePositions[k]);
+    }
+    // position relative to the EEG sphere center of a position relative to the MEG sphere center
+    const Coordinate centerOffset = meg.sphereCenter() - eeg.sphereCenter();
+
+    return meg.leadFieldWithLeadingRows(dipolePositions, coilPositions, coilDirections, numberOfElectrodes,
+      [&](size_t blockBegin, size_t blockEnd, const Coordinate* dipolePos, FieldType* tile, size_t rowStride) {
+        TraceSpan kernelSpan("eegKernel", "jointLeadField");
+        std::vector<Coordinate> columns(numberOfElectrodes);
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+          eeg.centeredLeadFieldColumns(dipolePos[i - blockBegin] + centerOffset, electrodeDirections.data(), numberOfElectrodes, columns.data());
+          for(size_t k = 0; k < numberOfElectrodes; ++k) {
+            std::copy(columns[k].begin(), columns[k].end(), tile + k * rowStride + dim * (i - blockBegin));
+          }
+        }
+      }, numberOfThreads);
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_JOINT_LEADFIELD_HH
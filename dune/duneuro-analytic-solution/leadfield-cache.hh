@@ -0,0 +1,468 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_CACHE_HH
+#define DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_CACHE_HH
+
+#include <dune/common/fvector.hh>
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace duneuro {
+
+  // read only row major lead field matrix. The entries are kept alive by an owner, which is either a vector holding the
+  // entries or a memory mapping of a cache file.
+  template<class FieldType>
+  class LeadFieldView
+  {
+  public:
+    LeadFieldView(std::shared_ptr<const void> owner, const FieldType* data, size_t rows, size_t columns)
+      : owner_(std::move(owner))
+      , data_(data)
+      , rows_(rows)
+      , columns_(columns)
+    {
+    }
+
+    static LeadFieldView fromVector(std::vector<FieldType>&& values, size_t rows, size_t columns)
+    {
+      auto owner = std::make_shared<const std::vector<FieldType>>(std::move(values));
+      return LeadFieldView(owner, owner->data(), rows, columns);
+    }
+
+    const FieldType* data() const { return data_; }
+    size_t rows() const { return rows_; }
+    size_t columns() const { return columns_; }
+    const std::shared_ptr<const void>& owner() const { return owner_; }
+
+    FieldType operator()(size_t row, size_t column) const
+    {
+      return data_[row * columns_ + column];
+    }
+
+  private:
+    std::shared_ptr<const void> owner_;
+    const FieldType* data_;
+    size_t rows_;
+    size_t columns_;
+  };
+
+  // 128 bit hash of binary data, computed in two independent lanes over 8 byte words. Used to address cache entries, not
+  // meant to withstand deliberate collisions.
+  class GeometryHash
+  {
+  public:
+    void add(const void* data, size_t bytes)
+    {
+      const unsigned char* begin = static_cast<const unsigned char*>(data);
+      size_t i = 0;
+      for(; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, begin + i, 8);
+        addWord(word);
+      }
+      if(i < bytes) {
+        uint64_t word = 0;
+        std::memcpy(&word, begin + i, bytes - i);
+        addWord(word);
+      }
+      length_ += bytes;
+    }
+
+    template<class T>
+    void add(const T& value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values can be hashed");
+      add(&value, sizeof(T));
+    }
+
+    template<class K, int n>
+    void add(const Dune::FieldVector<K, n>& vector)
+    {
+      for(int i = 0; i < n; ++i) {
+        add(vector[i]);
+      }
+    }
+
+    template<class T>
+    void add(const std::vector<T>& values)
+    {
+      add(values.size());
+      for(const auto& value : values) {
+        add(value);
+      }
+    }
+
+    void add(const std::string& value)
+    {
+      add(value.size());
+      add(value.data(), value.size());
+    }
+
+    std::array<uint64_t, 2> digest() const
+    {
+      return {{finalize(lane1_ ^ length_), finalize(lane2_ + length_)}};
+    }
+
+    static std::string toHex(const std::array<uint64_t, 2>& digest)
+    {
+      std::ostringstream stream;
+      stream << std::hex << std::setfill('0') << std::setw(16) << digest[0] << std::setw(16) << digest[1];
+      return stream.str();
+    }
+
+  private:
+    uint64_t lane1_ = 0x243f6a8885a308d3ULL;
+    uint64_t lane2_ = 0x13198a2e03707344ULL;
+    uint64_t length_ = 0;
+
+    static uint64_t rotateLeft(uint64_t value, int bits)
+    {
+      return (value << bits) | (value >> (64 - bits));
+    }
+
+    void addWord(uint64_t word)
+    {
+      lane1_ = rotateLeft(lane1_ ^ (word * 0x9e3779b97f4a7c15ULL), 27) * 0xc2b2ae3d27d4eb4fULL + 0x165667b19e3779f9ULL;
+      lane2_ = rotateLeft(lane2_ + word * 0xc2b2ae3d27d4eb4fULL, 31) * 0x9e3779b97f4a7c15ULL ^ 0x85ebca77c2b2ae63ULL;
+    }
+
+    // finalizer of MurmurHash3
+    static uint64_t finalize(uint64_t value)
+    {
+      value ^= value >> 33;
+      value *= 0xff51afd7ed558ccdULL;
+      value ^= value >> 33;
+      value *= 0xc4ceb9fe1a85ec53ULL;
+      value ^= value >> 33;
+      return value;
+    }
+  };
+
+  // header of a cache file. The entries follow directly after the header, which keeps them 64 byte aligned in the mapping.
+  struct LeadFieldCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t scalarSize;
+    uint64_t rows;
+    uint64_t columns;
+    uint64_t key[2];
+    uint64_t reserved[2];
+  };
+  static_assert(sizeof(LeadFieldCacheHeader) == 64, "cache file header has to be 64 bytes");
+
+  // persistent cache of analytic lead fields in a directory. Every lead field is stored in its own file, named after a hash of
+  // everything it depends on: sphere center, scaling factor, coil positions and directions, dipole positions, the field type
+  // and the file format version. Hence changing any of these results in a new entry, and outdated entries are evicted
+  // eventually. On a hit, the file is mapped into memory instead of being read.
+  //
+  // Several processes may use the same directory at once. Files are written to a temporary file first and renamed afterwards,
+  // so that no process ever maps a partially written file. Eviction is serialized by a lock file. Entries that are evicted
+  // while mapped by another process stay valid in that process until unmapped. If maximumSize is larger than 0, the least
+  // recently used entries are removed as soon as the files in the directory exceed maximumSize bytes.
+  class LeadFieldCache
+  {
+  public:
+    static constexpr uint32_t version = 1;
+    static constexpr const char* fileExtension = ".lf";
+
+    explicit LeadFieldCache(const std::string& directory, uint64_t maximumSize = 0)
+      : directory_(directory)
+      , maximumSize_(maximumSize)
+      , hits_(0)
+      , misses_(0)
+    {
+      std::filesystem::create_directories(directory_);
+    }
+
+    // return the lead field of solver.leadField(dipolePositions, coilPositions, coilDirections, numberOfThreads), either from
+    // the cache or by computing and storing it. If storing fails, e.g. because the disk is full, the computed lead field is
+    // returned nonetheless.
+    template<class FieldType>
+    LeadFieldView<FieldType> leadField(const AnalyticSolutionMEG<FieldType>& solver,
+                                       const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& dipolePositions,
+                                       const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& coilPositions,
+                                       const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& coilDirections,
+                                       size_t numberOfThreads = 0)
+    {
+      auto key = leadFieldKey(solver, dipolePositions, coilPositions, coilDirections);
+      const size_t rows = coilPositions.size();
+      const size_t columns = AnalyticSolutionMEG<FieldType>::dim * dipolePositions.size();
+
+      std::filesystem::path path = entryPath(key);
+      auto mapped = map<FieldType>(path, key, rows, columns);
+      if(mapped) {
+        ++hits_;
+        touch(path);
+        return *mapped;
+      }
+
+      ++misses_;
+      auto values = solver.leadField(dipolePositions, coilPositions, coilDirections, numberOfThreads);
+      if(store(path, key, values.data(), rows, columns)) {
+        evict();
+      }
+      return LeadFieldView<FieldType>::fromVector(std::move(values), rows, columns);
+    }
+
+    // key of the cache entry of a lead field
+    template<class FieldType>
+    static std::array<uint64_t, 2> leadFieldKey(const AnalyticSolutionMEG<FieldType>& solver,
+                                                const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& dipolePositions,
+                                                const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& coilPositions,
+                                                const std::vector<typename AnalyticSolutionMEG<FieldType>::Coordinate>& coilDirections)
+    {
+      GeometryHash hash;
+      hash.add(version);
+      hash.add(std::string("meg.total"));
+      hash.add(static_cast<uint32_t>(sizeof(FieldType)));
+      hash.add(solver.sphereCenter());
+      hash.add(solver.scalingFactor());
+      hash.add(coilPositions);
+      hash.add(coilDirections);
+      hash.add(dipolePositions);
+      return hash.digest();
+    }
+
+    // remove all entries
+    void clear()
+    {
+      DirectoryLock lock(lockPath());
+      for(const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        if(isCacheFile(entry.path()) || isTemporaryFile(entry.path())) {
+          std::error_code error;
+          std::filesystem::remove(entry.path(), error);
+        }
+      }
+    }
+
+    // total size of the entries in bytes
+    uint64_t size() const
+    {
+      uint64_t total = 0;
+      for(const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(entry.path(), error);
+        if(!error && isCacheFile(entry.path())) {
+          total += fileSize;
+        }
+      }
+      return total;
+    }
+
+    const std::filesystem::path& directory() const { return directory_; }
+    uint64_t maximumSize() const { return maximumSize_; }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+  private:
+    std::filesystem::path directory_;
+    uint64_t maximumSize_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+
+    // temporary files older than this are left over from crashed processes and are removed during eviction
+    static constexpr std::chrono::hours temporaryFileLifetime{1};
+
+    // exclusive flock on a file in the cache directory, released on destruction
+    class DirectoryLock
+    {
+    public:
+      explicit DirectoryLock(const std::filesystem::path& path)
+        : fd_(::open(path.c_str(), O_RDWR | O_CREAT, 0644))
+      {
+        if(fd_ >= 0) {
+          ::flock(fd_, LOCK_EX);
+        }
+      }
+
+      DirectoryLock(const DirectoryLock&) = delete;
+      DirectoryLock& operator=(const DirectoryLock&) = delete;
+
+      ~DirectoryLock()
+      {
+        if(fd_ >= 0) {
+          ::flock(fd_, LOCK_UN);
+          ::close(fd_);
+        }
+      }
+
+    private:
+      int fd_;
+    };
+
+    std::filesystem::path entryPath(const std::array<uint64_t, 2>& key) const
+    {
+      return directory_ / (GeometryHash::toHex(key) + fileExtension);
+    }
+
+    std::filesystem::path lockPath() const
+    {
+      return directory_ / ".lock";
+    }
+
+    static bool isCacheFile(const std::filesystem::path& path)
+    {
+      return path.extension() == fileExtension;
+    }
+
+    static bool isTemporaryFile(const std::filesystem::path& path)
+    {
+      return path.filename().string().find(std::string(fileExtension) + ".tmp") != std::string::npos;
+    }
+
+    static void touch(const std::filesystem::path& path)
+    {
+      std::error_code error;
+      std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    }
+
+    // map the entry at path, if it exists and matches the expectations. Invalid entries are removed.
+    template<class FieldType>
+    std::unique_ptr<LeadFieldView<FieldType>> map(const std::filesystem::path& path, const std::array<uint64_t, 2>& key,
+                                                  size_t rows, size_t columns) const
+    {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0) {
+        return nullptr;
+      }
+      struct stat status;
+      LeadFieldCacheHeader header;
+      bool valid = ::fstat(fd, &status) == 0
+        && static_cast<uint64_t>(status.st_size) == sizeof(LeadFieldCacheHeader) + rows * columns * sizeof(FieldType)
+        && ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+        && std::memcmp(header.magic, magic(), sizeof(header.magic)) == 0
+        && header.version == version
+        && header.scalarSize == sizeof(FieldType)
+        && header.rows == rows
+        && header.columns == columns
+        && header.key[0] == key[0]
+        && header.key[1] == key[1];
+      if(!valid) {
+        ::close(fd);
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return nullptr;
+      }
+
+      size_t length = status.st_size;
+      void* address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if(address == MAP_FAILED) {
+        return nullptr;
+      }
+      std::shared_ptr<const void> owner(address, [length](const void* pointer) { ::munmap(const_cast<void*>(pointer), length); });
+      const FieldType* data = reinterpret_cast<const FieldType*>(static_cast<const char*>(address) + sizeof(LeadFieldCacheHeader));
+      return std::make_unique<LeadFieldView<FieldType>>(owner, data, rows, columns);
+    }
+
+    // atomically create the entry at path
+    template<class FieldType>
+    bool store(const std::filesystem::path& path, const std::array<uint64_t, 2>& key, const FieldType* data, size_t rows,
+               size_t columns) const
+    {
+      LeadFieldCacheHeader header = {};
+      std::memcpy(header.magic, magic(), sizeof(header.magic));
+      header.version = version;
+      header.scalarSize = sizeof(FieldType);
+      header.rows = rows;
+      header.columns = columns;
+      header.key[0] = key[0];
+      header.key[1] = key[1];
+
+      std::ostringstream temporaryName;
+      temporaryName << path.filename().string() << ".tmp." << ::getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+      std::filesystem::path temporaryPath = directory_ / temporaryName.str();
+      {
+        std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char*>(data), rows * columns * sizeof(FieldType));
+        output.close();
+        if(!output) {
+          std::error_code error;
+          std::filesystem::remove(temporaryPath, error);
+          return false;
+        }
+      }
+      std::error_code error;
+      std::filesystem::rename(temporaryPath, path, error);
+      if(error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+      }
+      return true;
+    }
+
+    // remove the least recently used entries until the cache fits into maximumSize
+    void evict() const
+    {
+      if(maximumSize_ == 0) {
+        return;
+      }
+      DirectoryLock lock(lockPath());
+
+      struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUse;
+        uint64_t size;
+      };
+      std::vector<Entry> entries;
+      uint64_t total = 0;
+      auto now = std::filesystem::file_time_type::clock::now();
+      for(const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        std::error_code error;
+        auto lastUse = std::filesystem::last_write_time(entry.path(), error);
+        if(error) {
+          continue;
+        }
+        if(isTemporaryFile(entry.path())) {
+          if(now - lastUse > temporaryFileLifetime) {
+            std::filesystem::remove(entry.path(), error);
+          }
+          continue;
+        }
+        uint64_t fileSize = std::filesystem::file_size(entry.path(), error);
+        if(error || !isCacheFile(entry.path())) {
+          continue;
+        }
+        entries.push_back({entry.path(), lastUse, fileSize});
+        total += fileSize;
+      }
+
+      std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+      for(size_t i = 0; i < entries.size() && total > maximumSize_; ++i) {
+        std::error_code error;
+        if(std::filesystem::remove(entries[i].path, error)) {
+          total -= entries[i].size;
+        }
+      }
+    }
+
+    static const char* magic()
+    {
+      return "DALFCACH";
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_CACHE_HH
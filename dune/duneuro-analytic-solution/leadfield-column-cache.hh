@@ -0,0 +1,189 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_COLUMN_CACHE_HH
+#define DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_COLUMN_CACHE_HH
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace duneuro {
+
+  // statistics of a LeadFieldColumnCache
+  struct LeadFieldColumnCacheStatistics {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t memoryUsage = 0; // in bytes
+  };
+
+  // least recently used cache of the #coils x 3 lead fields of single dipole positions for a fixed set of coils, meant for
+  // iterative inverse methods like dipole fits or MCMC sampling, which evaluate the same or nearby positions again and again.
+  //
+  // If tolerance is positive, positions are rounded to the grid of spacing tolerance, and the lead field is computed at the
+  // grid point. Hence all positions within a grid cell share one entry, and the result does not depend on which position was
+  // requested first. If tolerance is 0, only identical positions share an entry. Entries are evicted as soon as their total
+  // size exceeds memoryBudget bytes. The cache may be used from several threads at once.
+  template<class FieldType>
+  class LeadFieldColumnCache
+  {
+  public:
+    using Solver = AnalyticSolutionMEG<FieldType>;
+    using Coordinate = typename Solver::Coordinate;
+    using Columns = std::shared_ptr<const std::vector<FieldType>>;
+
+    LeadFieldColumnCache(const Solver& solver, const std::vector<Coordinate>& coilPositions,
+                         const std::vector<Coordinate>& coilDirections, size_t memoryBudget, FieldType tolerance = 0.0)
+      : solver_(solver)
+      , coilPositions_(coilPositions)
+      , coilDirections_(coilDirections)
+      , memoryBudget_(memoryBudget)
+      , tolerance_(tolerance)
+    {
+      if(coilPositions_.size() != coilDirections_.size()) {
+        throw std::invalid_argument("number of coil positions and number of coil directions differ");
+      }
+      if(tolerance_ < 0.0) {
+        throw std::invalid_argument("tolerance has to be non-negative");
+      }
+    }
+
+    // return the #coils x 3 row major lead field at the given position, computing it on a miss. The returned columns stay valid
+    // even if the entry is evicted afterwards.
+    Columns leadField(const Coordinate& position)
+    {
+      Key key = quantize(position);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto entry = entries_.find(key);
+        if(entry != entries_.end()) {
+          ++statistics_.hits;
+          // move to the front of the usage list
+          usage_.splice(usage_.begin(), usage_, entry->second);
+          return entry->second->second;
+        }
+        ++statistics_.misses;
+      }
+
+      // compute outside of the lock, so that other threads can use the cache meanwhile
+      Columns columns = std::make_shared<const std::vector<FieldType>>(
+        solver_.leadField(representative(key, position), coilPositions_, coilDirections_));
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(entries_.find(key) == entries_.end() && entrySize() <= memoryBudget_) {
+        usage_.emplace_front(key, columns);
+        entries_.emplace(key, usage_.begin());
+        statistics_.memoryUsage += entrySize();
+        while(statistics_.memoryUsage > memoryBudget_) {
+          entries_.erase(usage_.back().first);
+          usage_.pop_back();
+          statistics_.memoryUsage -= entrySize();
+          ++statistics_.evictions;
+        }
+      }
+      return columns;
+    }
+
+    LeadFieldColumnCacheStatistics statistics() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      LeadFieldColumnCacheStatistics statistics = statistics_;
+      statistics.entries = entries_.size();
+      return statistics;
+    }
+
+    // reset hits, misses and evictions, but keep the entries
+    void resetStatistics()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      statistics_.hits = 0;
+      statistics_.misses = 0;
+      statistics_.evictions = 0;
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      entries_.clear();
+      usage_.clear();
+      statistics_.memoryUsage = 0;
+    }
+
+    size_t numberOfCoils() const { return coilPositions_.size(); }
+    size_t memoryBudget() const { return memoryBudget_; }
+    FieldType tolerance() const { return tolerance_; }
+
+  private:
+    // grid indices of a quantized position, or the bit patterns of the coordinates if the tolerance is 0
+    using Key = std::array<int64_t, Solver::dim>;
+
+    struct KeyHash {
+      size_t operator()(const Key& key) const
+      {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for(auto value : key) {
+          hash = (hash ^ static_cast<uint64_t>(value)) * 0x100000001b3ULL;
+        }
+        return hash;
+      }
+    };
+
+    using UsageList = std::list<std::pair<Key, Columns>>;
+
+    Solver solver_;
+    std::vector<Coordinate> coilPositions_;
+    std::vector<Coordinate> coilDirections_;
+    size_t memoryBudget_;
+    FieldType tolerance_;
+
+    mutable std::mutex mutex_;
+    UsageList usage_; // most recently used entry first
+    std::unordered_map<Key, typename UsageList::iterator, KeyHash> entries_;
+    LeadFieldColumnCacheStatistics statistics_;
+
+    // memory of one entry, including the bookkeeping
+    size_t entrySize() const
+    {
+      return Solver::dim * coilPositions_.size() * sizeof(FieldType) + sizeof(typename UsageList::value_type) + sizeof(std::vector<FieldType>) + 64;
+    }
+
+    Key quantize(const Coordinate& position) const
+    {
+      Key key;
+      for(size_t i = 0; i < Solver::dim; ++i) {
+        if(tolerance_ > 0.0) {
+          key[i] = static_cast<int64_t>(std::llround(position[i] / tolerance_));
+        }
+        else {
+          // add 0.0 to map -0.0 to 0.0
+          double value = position[i] + 0.0;
+          std::memcpy(&key[i], &value, sizeof(value));
+        }
+      }
+      return key;
+    }
+
+    // position at which the lead field of an entry is computed
+    Coordinate representative(const Key& key, const Coordinate& position) const
+    {
+      if(tolerance_ == 0.0) {
+        return position;
+      }
+      Coordinate gridPoint;
+      for(size_t i = 0; i < Solver::dim; ++i) {
+        gridPoint[i] = key[i] * tolerance_;
+      }
+      return gridPoint;
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_COLUMN_CACHE_HH
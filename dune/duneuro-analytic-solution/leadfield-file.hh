@@ -0,0 +1,177 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_FILE_HH
+#define DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_FILE_HH
+
+#include <dune/duneuro-analytic-solution/leadfield-cache.hh>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace duneuro {
+
+  // field of a lead field file
+  enum class LeadFieldFileField : uint32_t { total = 0, primary = 1, secondary = 2 };
+
+  // header of a lead field file, e.g. written by compute-leadfield. The row major matrix of rows x columns entries of scalarSize
+  // bytes follows directly after the header, which keeps it 64 byte aligned in a mapping, so that it can be used in place, e.g.
+  // with numpy.memmap(filename, dtype, offset=64, shape=(rows, columns)). All fields are stored in native byte order.
+  struct LeadFieldFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t scalarSize;
+    uint64_t rows;
+    uint64_t columns;
+    uint32_t field;
+    uint32_t reserved0;
+    uint64_t reserved[3];
+  };
+  static_assert(sizeof(LeadFieldFileHeader) == 64, "lead field file header has to be 64 bytes");
+
+  constexpr uint32_t leadFieldFileVersion = 1;
+
+  inline const char* leadFieldFileMagic()
+  {
+    return "DALFFILE";
+  }
+
+  // check that a lead field file of fileSize bytes holds exactly rows x columns scalars of scalarSize bytes. The sizes are
+  // compared by division, so that the product cannot overflow for a corrupt header.
+  inline bool leadFieldFileSizeMatches(uint64_t fileSize, uint64_t rows, uint64_t columns, uint64_t scalarSize)
+  {
+    if(fileSize < sizeof(LeadFieldFileHeader) || scalarSize == 0 || (fileSize - sizeof(LeadFieldFileHeader)) % scalarSize != 0) {
+      return false;
+    }
+    const uint64_t entries = (fileSize - sizeof(LeadFieldFileHeader)) / scalarSize;
+    if(rows == 0 || columns == 0) {
+      return entries == 0;
+    }
+    return entries % rows == 0 && entries / rows == columns;
+  }
+
+  // creates a lead field file of the given size and maps it, such that the entries can be written in place, e.g. one block of
+  // columns after another, without holding the whole matrix in memory. Throws if the size exceeds the address space or the file
+  // cannot be created or mapped.
+  template<class FieldType>
+  class LeadFieldFileWriter
+  {
+  public:
+    LeadFieldFileWriter(const std::string& filename, size_t rows, size_t columns, LeadFieldFileField field)
+      : rows_(rows)
+      , columns_(columns)
+      , length_(checkedLength(rows, columns))
+    {
+      int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd < 0) {
+        throw std::runtime_error("could not create lead field file " + filename);
+      }
+      if(::ftruncate(fd, length_) != 0) {
+        ::close(fd);
+        throw std::runtime_error("could not resize lead field file " + filename);
+      }
+      address_ = ::mmap(nullptr, length_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if(address_ == MAP_FAILED) {
+        throw std::runtime_error("could not map lead field file " + filename);
+      }
+
+      LeadFieldFileHeader header = {};
+      std::memcpy(header.magic, leadFieldFileMagic(), sizeof(header.magic));
+      header.version = leadFieldFileVersion;
+      header.scalarSize = sizeof(FieldType);
+      header.rows = rows;
+      header.columns = columns;
+      header.field = static_cast<uint32_t>(field);
+      std::memcpy(address_, &header, sizeof(header));
+    }
+
+    LeadFieldFileWriter(const LeadFieldFileWriter&) = delete;
+    LeadFieldFileWriter& operator=(const LeadFieldFileWriter&) = delete;
+
+    ~LeadFieldFileWriter()
+    {
+      ::munmap(address_, length_);
+    }
+
+    FieldType* data()
+    {
+      return reinterpret_cast<FieldType*>(static_cast<char*>(address_) + sizeof(LeadFieldFileHeader));
+    }
+
+    // copy the row major block of rows x blockColumns entries into the columns firstColumn, ..., firstColumn + blockColumns - 1
+    void writeColumns(const FieldType* block, size_t blockColumns, size_t firstColumn)
+    {
+      if(firstColumn + blockColumns > columns_) {
+        throw std::invalid_argument("block of columns exceeds the lead field file");
+      }
+      for(size_t row = 0; row < rows_; ++row) {
+        std::copy_n(block + row * blockColumns, blockColumns, data() + row * columns_ + firstColumn);
+      }
+    }
+
+    // write the mapped pages back to the file. Throws on failure.
+    void sync()
+    {
+      if(::msync(address_, length_, MS_SYNC) != 0) {
+        throw std::runtime_error("could not write the lead field file");
+      }
+    }
+
+  private:
+    static size_t checkedLength(size_t rows, size_t columns)
+    {
+      const size_t maximumEntries = (std::numeric_limits<size_t>::max() - sizeof(LeadFieldFileHeader)) / sizeof(FieldType);
+      if(columns != 0 && rows > maximumEntries / columns) {
+        throw std::invalid_argument("lead field file of the given size exceeds the address space");
+      }
+      return sizeof(LeadFieldFileHeader) + rows * columns * sizeof(FieldType);
+    }
+
+    size_t rows_;
+    size_t columns_;
+    size_t length_;
+    void* address_;
+  };
+
+  // map a lead field file written with scalars of type FieldType into memory. Throws if the file cannot be read or does not
+  // contain such a lead field.
+  template<class FieldType>
+  LeadFieldView<FieldType> mapLeadFieldFile(const std::string& filename)
+  {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+      throw std::runtime_error("could not open lead field file " + filename);
+    }
+    struct stat status;
+    LeadFieldFileHeader header;
+    bool valid = ::fstat(fd, &status) == 0
+      && ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+      && std::memcmp(header.magic, leadFieldFileMagic(), sizeof(header.magic)) == 0
+      && header.version == leadFieldFileVersion
+      && header.scalarSize == sizeof(FieldType)
+      && leadFieldFileSizeMatches(status.st_size, header.rows, header.columns, sizeof(FieldType));
+    if(!valid) {
+      ::close(fd);
+      throw std::invalid_argument(filename + " is not a lead field file of the requested precision");
+    }
+
+    size_t length = status.st_size;
+    void* address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(address == MAP_FAILED) {
+      throw std::runtime_error("could not map lead field file " + filename);
+    }
+    std::shared_ptr<const void> owner(address, [length](const void* pointer) { ::munmap(const_cast<void*>(pointer), length); });
+    const FieldType* data = reinterpret_cast<const FieldType*>(static_cast<const char*>(address) + sizeof(LeadFieldFileHeader));
+    return LeadFieldView<FieldType>(owner, data, header.rows, header.columns);
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_LEADFIELD_FILE_HH
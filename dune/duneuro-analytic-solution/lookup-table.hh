@@ -0,0 +1,299 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_LOOKUP_TABLE_HH
+#define DUNEURO_ANALYTIC_SOLUTION_LOOKUP_TABLE_HH
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace duneuro {
+
+  // approximate evaluation of the lead field of the total field for sensors on a sphere of fixed radius r around the sphere
+  // center, using a lookup table.
+  //
+  // Writing the dipole position as R_0 = r_0 * u with |u| = 1, the lead field columns of AnalyticSolutionMEG::leadField become
+  //   r_0 * (g_1 * (u x d) - (g_2 * (R * d) + r_0 * g_3 * (u * d)) * (u x R)),
+  // where g_1 = s / F, g_2 = s * alpha / F^2 and g_3 = s * beta / F^2, with grad_F = alpha * R + beta * R_0 and the scaling
+  // factor s. For fixed r, the invariants g_1, g_2 and g_3 only depend on r_0 and on the cosine c of the angle between R_0 and
+  // R, and they are smooth and nonzero down to r_0 = 0. They are tabulated on a uniform grid over [0, maximumDipoleRadius] x
+  // [-1, 1] and evaluated by cubic interpolation, first in r_0 once per dipole and then in c per coil, followed by the cross
+  // products above, which take the place of the rotation into the frame of the dipole. No square roots or divisions remain per
+  // pair of dipole and coil.
+  //
+  // The table is refined until the interpolation error, relative to the largest magnitude of the respective invariant at the
+  // same dipole radius, is below the tolerance at all midpoints of the grid cells. This is an a posteriori estimate, not a
+  // rigorous bound, but since the invariants are smooth for r_0 < r, the error between the midpoints behaves alike.
+  template<class FieldType>
+  class TabulatedAnalyticSolutionMEG
+  {
+  public:
+    using Solver = AnalyticSolutionMEG<FieldType>;
+    using Coordinate = typename Solver::Coordinate;
+    static constexpr size_t dim = Solver::dim;
+    static constexpr size_t numberOfInvariants = 3;
+
+    // build the table for sensors at distance sensorRadius and dipoles at distance at most maximumDipoleRadius from the sphere
+    // center of solver. Throws if the tolerance cannot be reached with at most maximumTableSize grid points.
+    TabulatedAnalyticSolutionMEG(const Solver& solver, FieldType sensorRadius, FieldType maximumDipoleRadius,
+                                 FieldType tolerance = 1e-6, size_t maximumTableSize = size_t(1) << 22)
+      : sphereCenter_(solver.sphereCenter())
+      , scalingFactor_(solver.scalingFactor())
+      , sensorRadius_(sensorRadius)
+      , maximumDipoleRadius_(maximumDipoleRadius)
+      , tolerance_(tolerance)
+      , radiusPoints_(16)
+      , anglePoints_(64)
+    {
+      if(!(maximumDipoleRadius > 0.0 && maximumDipoleRadius < sensorRadius)) {
+        throw std::invalid_argument("the maximum dipole radius has to be positive and smaller than the sensor radius");
+      }
+      if(!(tolerance > 0.0)) {
+        throw std::invalid_argument("the tolerance has to be positive");
+      }
+
+      while(true) {
+        buildTable();
+        FieldType radialError = estimateRadialError();
+        FieldType angularError = estimateAngularError();
+        errorEstimate_ = std::max(radialError, angularError);
+        if(errorEstimate_ <= tolerance_) {
+          break;
+        }
+        size_t radiusPoints = radialError > 0.5 * tolerance_ ? 2 * radiusPoints_ - 1 : radiusPoints_;
+        size_t anglePoints = angularError > 0.5 * tolerance_ ? 2 * anglePoints_ - 1 : anglePoints_;
+        if(radiusPoints * anglePoints > maximumTableSize) {
+          throw std::runtime_error("lookup table cannot reach the tolerance " + std::to_string(tolerance_) + " within "
+                                   + std::to_string(maximumTableSize) + " grid points, the error estimate is " + std::to_string(errorEstimate_));
+        }
+        radiusPoints_ = radiusPoints;
+        anglePoints_ = anglePoints;
+      }
+    }
+
+    // approximate Solver::leadField for the given dipole positions and coils. All coils have to lie on the sensor sphere, and
+    // all dipoles inside of the maximum dipole radius.
+    std::vector<FieldType> leadField(const std::vector<Coordinate>& dipolePositions,
+                                     const std::vector<Coordinate>& coilPositions,
+                                     const std::vector<Coordinate>& coilDirections,
+                                     size_t numberOfThreads = 0) const
+    {
+      if(coilPositions.size() != coilDirections.size()) {
+        throw std::invalid_argument("number of coil positions and number of coil directions differ");
+      }
+      const size_t numberOfCoils = coilPositions.size();
+      const size_t numberOfColumns = dim * dipolePositions.size();
+
+      // per coil: position relative to the sphere center, its direction and R * d
+      std::vector<Coordinate> R(numberOfCoils);
+      std::vector<Coordinate> RHat(numberOfCoils);
+      std::vector<FieldType> RTimesD(numberOfCoils);
+      for(size_t coil = 0; coil < numberOfCoils; ++coil) {
+        R[coil] = coilPositions[coil] - sphereCenter_;
+        FieldType r = R[coil].two_norm();
+        if(std::abs(r - sensorRadius_) > sensorRadiusTolerance * sensorRadius_) {
+          throw std::invalid_argument("coil " + std::to_string(coil) + " does not lie on the sensor sphere of the lookup table");
+        }
+        RHat[coil] = R[coil] / r;
+        RTimesD[coil] = R[coil] * coilDirections[coil];
+      }
+      for(size_t i = 0; i < dipolePositions.size(); ++i) {
+        if((dipolePositions[i] - sphereCenter_).two_norm() > maximumDipoleRadius_) {
+          throw std::invalid_argument("dipole " + std::to_string(i) + " lies outside of the maximum dipole radius of the lookup table");
+        }
+      }
+
+      std::vector<FieldType> result(numberOfCoils * numberOfColumns);
+      std::vector<std::vector<FieldType>> tiles(resolveNumberOfThreads(numberOfThreads));
+      std::vector<std::vector<FieldType>> rows(tiles.size(), std::vector<FieldType>(rowSize()));
+
+      parallelForBlocks(dipolePositions.size(), blockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t threadIndex) {
+        const size_t tileColumns = dim * (blockEnd - blockBegin);
+        auto& tile = tiles[threadIndex];
+        auto& row = rows[threadIndex];
+        tile.resize(numberOfCoils * tileColumns);
+
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+          Coordinate u = dipolePositions[i] - sphereCenter_;
+          FieldType r0 = u.two_norm();
+          if(r0 > 0.0) {
+            u /= r0;
+          }
+          interpolateRadius(r0, row.data());
+
+          FieldType* tileColumn = tile.data() + dim * (i - blockBegin);
+          for(size_t coil = 0; coil < numberOfCoils; ++coil) {
+            FieldType c = std::min<FieldType>(std::max<FieldType>(u * RHat[coil], -1.0), 1.0);
+            std::array<FieldType, numberOfInvariants> g;
+            interpolateAngle(row.data(), c, g);
+            const Coordinate& d = coilDirections[coil];
+            Coordinate uCrossR = Solver::crossProduct(u, R[coil]);
+            Coordinate columns = Solver::crossProduct(u, d);
+            columns *= g[0];
+            columns.axpy(-(g[1] * RTimesD[coil] + r0 * g[2] * (u * d)), uCrossR);
+            columns *= r0;
+            std::copy(columns.begin(), columns.end(), tileColumn + coil * tileColumns);
+          }
+        }
+
+        for(size_t coil = 0; coil < numberOfCoils; ++coil) {
+          std::copy_n(tile.data() + coil * tileColumns, tileColumns, result.data() + coil * numberOfColumns + dim * blockBegin);
+        }
+      });
+
+      return result;
+    }
+
+    // the invariants g_1, g_2 and g_3 for a dipole at distance r0 from the sphere center and the cosine c of the angle
+    // between dipole and sensor, computed exactly
+    std::array<FieldType, numberOfInvariants> invariants(FieldType r0, FieldType c) const
+    {
+      FieldType r = sensorRadius_;
+      Coordinate R0(0.0);
+      R0[0] = r0;
+      Coordinate R(0.0);
+      R[0] = r * c;
+      R[1] = r * std::sqrt(std::max<FieldType>(0.0, 1.0 - c * c));
+      Coordinate A = R - R0;
+      FieldType a = A.two_norm();
+      FieldType F = a * (r * a + r * r - R0 * R);
+      FieldType alpha = a*a/r + A * R/a + 2*(a + r);
+      FieldType beta = -(a + 2*r + A * R/a);
+      return {{scalingFactor_ / F, scalingFactor_ * alpha / (F * F), scalingFactor_ * beta / (F * F)}};
+    }
+
+    FieldType sensorRadius() const { return sensorRadius_; }
+    FieldType maximumDipoleRadius() const { return maximumDipoleRadius_; }
+    FieldType tolerance() const { return tolerance_; }
+    // largest relative interpolation error found at the midpoints of the grid cells
+    FieldType errorEstimate() const { return errorEstimate_; }
+    size_t radiusPoints() const { return radiusPoints_; }
+    size_t anglePoints() const { return anglePoints_; }
+
+  private:
+    // relative deviation of the coil distance from the sensor radius that is accepted
+    static constexpr FieldType sensorRadiusTolerance = 1e-6;
+    // number of dipole positions a thread processes at once
+    static constexpr size_t blockSize = 16;
+
+    Coordinate sphereCenter_;
+    FieldType scalingFactor_;
+    FieldType sensorRadius_;
+    FieldType maximumDipoleRadius_;
+    FieldType tolerance_;
+    FieldType errorEstimate_;
+    size_t radiusPoints_;
+    size_t anglePoints_;
+    // invariants at the grid points, (radius, angle, invariant) in row major order
+    std::vector<FieldType> table_;
+
+    FieldType radiusSpacing() const { return maximumDipoleRadius_ / (radiusPoints_ - 1); }
+    FieldType angleSpacing() const { return 2.0 / (anglePoints_ - 1); }
+    size_t rowSize() const { return anglePoints_ * numberOfInvariants; }
+
+    void buildTable()
+    {
+      table_.resize(radiusPoints_ * anglePoints_ * numberOfInvariants);
+      for(size_t i = 0; i < radiusPoints_; ++i) {
+        for(size_t j = 0; j < anglePoints_; ++j) {
+          auto g = invariants(i * radiusSpacing(), -1.0 + j * angleSpacing());
+          std::copy(g.begin(), g.end(), table_.begin() + (i * anglePoints_ + j) * numberOfInvariants);
+        }
+      }
+    }
+
+    // first node and weights of the cubic Lagrange interpolation at x, given in units of the grid spacing, on a grid of the
+    // given number of points. At the boundary, the stencil is shifted inwards.
+    static size_t cubicStencil(FieldType x, size_t points, std::array<FieldType, 4>& weights)
+    {
+      long first = static_cast<long>(std::floor(x)) - 1;
+      first = std::min<long>(std::max<long>(first, 0), static_cast<long>(points) - 4);
+      FieldType t = x - first;
+      weights[0] = -(t - 1) * (t - 2) * (t - 3) / 6;
+      weights[1] = t * (t - 2) * (t - 3) / 2;
+      weights[2] = -t * (t - 1) * (t - 3) / 2;
+      weights[3] = t * (t - 1) * (t - 2) / 6;
+      return first;
+    }
+
+    // interpolate the table at radius r0 for all angles
+    void interpolateRadius(FieldType r0, FieldType* row) const
+    {
+      std::array<FieldType, 4> weights;
+      const FieldType* tableRow = table_.data() + cubicStencil(r0 / radiusSpacing(), radiusPoints_, weights) * rowSize();
+      for(size_t k = 0; k < rowSize(); ++k) {
+        row[k] = weights[0] * tableRow[k] + weights[1] * tableRow[rowSize() + k]
+          + weights[2] * tableRow[2 * rowSize() + k] + weights[3] * tableRow[3 * rowSize() + k];
+      }
+    }
+
+    // interpolate a row returned by interpolateRadius at the cosine c
+    void interpolateAngle(const FieldType* row, FieldType c, std::array<FieldType, numberOfInvariants>& g) const
+    {
+      std::array<FieldType, 4> weights;
+      size_t first = cubicStencil((c + 1.0) / angleSpacing(), anglePoints_, weights);
+      const FieldType* values = row + first * numberOfInvariants;
+      for(size_t q = 0; q < numberOfInvariants; ++q) {
+        g[q] = weights[0] * values[q] + weights[1] * values[numberOfInvariants + q]
+          + weights[2] * values[2 * numberOfInvariants + q] + weights[3] * values[3 * numberOfInvariants + q];
+      }
+    }
+
+    // largest error of the interpolation in radius direction, checked at the radial midpoints of the cells for all angles
+    FieldType estimateRadialError() const
+    {
+      FieldType maximumError = 0.0;
+      std::vector<FieldType> row(anglePoints_ * numberOfInvariants);
+      for(size_t i = 0; i + 1 < radiusPoints_; ++i) {
+        FieldType r0 = (i + 0.5) * radiusSpacing();
+        interpolateRadius(r0, row.data());
+        std::vector<FieldType> exact(row.size());
+        std::array<FieldType, numberOfInvariants> scale = {};
+        for(size_t j = 0; j < anglePoints_; ++j) {
+          auto g = invariants(r0, -1.0 + j * angleSpacing());
+          for(size_t q = 0; q < numberOfInvariants; ++q) {
+            exact[j * numberOfInvariants + q] = g[q];
+            scale[q] = std::max(scale[q], std::abs(g[q]));
+          }
+        }
+        for(size_t k = 0; k < row.size(); ++k) {
+          FieldType rowScale = scale[k % numberOfInvariants];
+          if(rowScale > 0.0) {
+            maximumError = std::max(maximumError, std::abs(row[k] - exact[k]) / rowScale);
+          }
+        }
+      }
+      return maximumError;
+    }
+
+    // largest error of the interpolation in angle direction, checked at the angular midpoints of the cells for all radii
+    FieldType estimateAngularError() const
+    {
+      FieldType maximumError = 0.0;
+      for(size_t i = 0; i < radiusPoints_; ++i) {
+        const FieldType* row = table_.data() + i * anglePoints_ * numberOfInvariants;
+        std::array<FieldType, numberOfInvariants> scale = {};
+        for(size_t k = 0; k < anglePoints_ * numberOfInvariants; ++k) {
+          scale[k % numberOfInvariants] = std::max(scale[k % numberOfInvariants], std::abs(row[k]));
+        }
+        for(size_t j = 0; j + 1 < anglePoints_; ++j) {
+          FieldType c = -1.0 + (j + 0.5) * angleSpacing();
+          auto exact = invariants(i * radiusSpacing(), c);
+          std::array<FieldType, numberOfInvariants> g;
+          interpolateAngle(row, c, g);
+          for(size_t q = 0; q < numberOfInvariants; ++q) {
+            if(scale[q] > 0.0) {
+              maximumError = std::max(maximumError, std::abs(g[q] - exact[q]) / scale[q]);
+            }
+          }
+        }
+      }
+      return maximumError;
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_LOOKUP_TABLE_HH
@@ -0,0 +1,44 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_MULTI_AXIS_SENSOR_HH
+#define DUNEURO_ANALYTIC_SOLUTION_MULTI_AXIS_SENSOR_HH
+
+#include <dune/common/fvector.hh>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace duneuro {
+
+  // sensor measuring the projections of the field at one position onto up to three axes, e.g. a triaxial optically pumped
+  // magnetometer. The axes are not normalized, so that they may carry per-axis gains.
+  template<class FieldType>
+  struct MultiAxisSensor {
+    static constexpr size_t dim = 3;
+    static constexpr size_t maximumNumberOfAxes = 3;
+    using Coordinate = Dune::FieldVector<FieldType, dim>;
+
+    Coordinate position;
+    std::array<Coordinate, maximumNumberOfAxes> axes;
+    size_t numberOfAxes;
+
+    MultiAxisSensor()
+      : position(0.0)
+      , numberOfAxes(0)
+    {
+    }
+
+    // throws if there are no axes or more than maximumNumberOfAxes axes
+    MultiAxisSensor(const Coordinate& position_, const std::vector<Coordinate>& axes_)
+      : position(position_)
+      , numberOfAxes(axes_.size())
+    {
+      if(numberOfAxes == 0 || numberOfAxes > maximumNumberOfAxes) {
+        throw std::invalid_argument("a multi-axis sensor needs between 1 and 3 axes");
+      }
+      for(size_t axis = 0; axis < numberOfAxes; ++axis) {
+        axes[axis] = axes_[axis];
+      }
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_MULTI_AXIS_SENSOR_HH
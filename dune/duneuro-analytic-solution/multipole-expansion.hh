@@ -0,0 +1,449 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_MULTIPOLE_EXPANSION_HH
+#define DUNEURO_ANALYTIC_SOLUTION_MULTIPOLE_EXPANSION_HH
+
+#include <dune/common/fvector.hh>
+#include <duneuro/common/dipole.hh>
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace duneuro {
+
+  // number of coefficients of a multipole expansion containing all degrees 1 <= l <= order
+  inline size_t numberOfMultipoleCoefficients(size_t order)
+  {
+    return order * (order + 2);
+  }
+
+  // position of the coefficient of degree l and order m in a multipole expansion. For every degree, the coefficients are
+  // ordered as (l, 0), (l, 1, cos), (l, 1, sin), ..., (l, l, cos), (l, l, sin).
+  inline size_t multipoleIndex(size_t l, size_t m, bool sine)
+  {
+    return l * l - 1 + (m == 0 ? 0 : 2 * m - (sine ? 0 : 1));
+  }
+
+  // real solid harmonics of degree 1 <= l <= order around the origin, given in spherical coordinates by
+  //   irregular: r^-(l+1) P_l^m(cos theta) cos(m phi) and r^-(l+1) P_l^m(cos theta) sin(m phi),
+  //   regular:   r^l P_l^m(cos theta) cos(m phi) and r^l P_l^m(cos theta) sin(m phi),
+  // where P_l^m are the associated Legendre functions without Condon-Shortley phase, scaled by sqrt((2l+1)(l-m)!/(l+m)!) such
+  // that their square integrates to 2 over [-1, 1]. The irregular harmonics span the magnetic scalar potentials of sources
+  // inside of a sphere around the origin, the regular ones those of sources outside of it. Their gradients are computed
+  // without dividing by sin(theta), using the functions P_l^m / sin(theta) for m >= 1, so that positions on the z-axis are fine.
+  template<class FieldType>
+  class SolidHarmonics
+  {
+  public:
+    using Coordinate = Dune::FieldVector<FieldType, 3>;
+    enum class Kind { irregular, regular };
+
+    explicit SolidHarmonics(size_t order)
+      : order_(order)
+      , a_((order + 1) * (order + 1), 0.0)
+      , b_((order + 1) * (order + 1), 0.0)
+    {
+      if(order == 0) {
+        throw std::invalid_argument("the order of the solid harmonics has to be positive");
+      }
+      // coefficients of the three term recurrence in the degree
+      for(size_t m = 0; m <= order_; ++m) {
+        for(size_t l = m + 2; l <= order_; ++l) {
+          FieldType lm = static_cast<FieldType>(l * l - m * m);
+          a_[index(l, m)] = std::sqrt((4.0 * l * l - 1.0) / lm);
+          b_[index(l, m)] = std::sqrt((2.0 * l + 1.0) * ((l - 1.0) * (l - 1.0) - m * m) / ((2.0 * l - 3.0) * lm));
+        }
+      }
+    }
+
+    size_t order() const { return order_; }
+    size_t size() const { return numberOfMultipoleCoefficients(order_); }
+
+    // the scaled functions P_l^0(x) for 0 <= l <= order in p0[l] and P_l^m(x) / sin(theta) for 1 <= m <= l <= order in
+    // q[l * (order + 1) + m], where x = cos(theta). Both arrays have to hold (order + 1)^2 entries.
+    void legendre(FieldType x, FieldType sinTheta, FieldType* p0, FieldType* q) const
+    {
+      p0[0] = 1.0;
+      p0[1] = std::sqrt(3.0) * x;
+      for(size_t l = 2; l <= order_; ++l) {
+        p0[l] = a_[index(l, 0)] * x * p0[l - 1] - b_[index(l, 0)] * p0[l - 2];
+      }
+
+      FieldType diagonal = std::sqrt(1.5);
+      for(size_t m = 1; m <= order_; ++m) {
+        if(m > 1) {
+          diagonal *= std::sqrt((2.0 * m + 1.0) / (2.0 * m)) * sinTheta;
+        }
+        q[index(m, m)] = diagonal;
+        if(m + 1 <= order_) {
+          q[index(m + 1, m)] = std::sqrt(2.0 * m + 3.0) * x * diagonal;
+        }
+        for(size_t l = m + 2; l <= order_; ++l) {
+          q[index(l, m)] = a_[index(l, m)] * x * q[index(l - 1, m)] - b_[index(l, m)] * q[index(l - 2, m)];
+        }
+      }
+    }
+
+    // gradients of all harmonics of the given kind at the position R, ordered as in multipoleIndex. result has to hold size()
+    // entries.
+    void gradients(const Coordinate& R, Kind kind, Coordinate* result) const
+    {
+      FieldType r = R.two_norm();
+      if(!(r > 0.0)) {
+        throw std::invalid_argument("solid harmonics cannot be evaluated at the origin");
+      }
+      FieldType rho = std::sqrt(R[0] * R[0] + R[1] * R[1]);
+      FieldType x = R[2] / r;
+      FieldType sinTheta = rho / r;
+      FieldType cosPhi = rho > 0.0 ? R[0] / rho : 1.0;
+      FieldType sinPhi = rho > 0.0 ? R[1] / rho : 0.0;
+
+      // unit vectors of the spherical coordinate system
+      Coordinate eR = R / r;
+      Coordinate eTheta = {x * cosPhi, x * sinPhi, -sinTheta};
+      Coordinate ePhi = {-sinPhi, cosPhi, 0.0};
+
+      std::vector<FieldType> p0(order_ + 1);
+      std::vector<FieldType> q((order_ + 1) * (order_ + 1), 0.0);
+      legendre(x, sinTheta, p0.data(), q.data());
+
+      // cos(m phi) and sin(m phi)
+      std::vector<FieldType> cosM(order_ + 1);
+      std::vector<FieldType> sinM(order_ + 1);
+      cosM[0] = 1.0;
+      sinM[0] = 0.0;
+      for(size_t m = 1; m <= order_; ++m) {
+        cosM[m] = cosM[m - 1] * cosPhi - sinM[m - 1] * sinPhi;
+        sinM[m] = sinM[m - 1] * cosPhi + cosM[m - 1] * sinPhi;
+      }
+
+      for(size_t l = 1; l <= order_; ++l) {
+        // radial factor divided by r and its derivative
+        FieldType radial, radialDerivative;
+        if(kind == Kind::irregular) {
+          radial = std::pow(r, -static_cast<FieldType>(l + 2));
+          radialDerivative = -(l + 1.0) * radial;
+        }
+        else {
+          radial = std::pow(r, static_cast<FieldType>(l) - 1.0);
+          radialDerivative = l * radial;
+        }
+
+        // m = 0, where d/dtheta P_l^0 = -sqrt(l (l + 1)) sin(theta) q_l^1
+        Coordinate& zonal = result[multipoleIndex(l, 0, false)];
+        zonal = eR;
+        zonal *= radialDerivative * p0[l];
+        zonal.axpy(-radial * std::sqrt(l * (l + 1.0)) * sinTheta * q[index(l, 1)], eTheta);
+
+        for(size_t m = 1; m <= l; ++m) {
+          FieldType p = sinTheta * q[index(l, m)];
+          FieldType lowerQ = m < l ? q[index(l - 1, m)] : 0.0;
+          FieldType dTheta = l * x * q[index(l, m)] - std::sqrt((2.0 * l + 1.0) * (l - m) * (l + m) / (2.0 * l - 1.0)) * lowerQ;
+          FieldType dPhi = m * q[index(l, m)];
+
+          Coordinate& cosine = result[multipoleIndex(l, m, false)];
+          cosine = eR;
+          cosine *= radialDerivative * p * cosM[m];
+          cosine.axpy(radial * dTheta * cosM[m], eTheta);
+          cosine.axpy(-radial * dPhi * sinM[m], ePhi);
+
+          Coordinate& sine = result[multipoleIndex(l, m, true)];
+          sine = eR;
+          sine *= radialDerivative * p * sinM[m];
+          sine.axpy(radial * dTheta * sinM[m], eTheta);
+          sine.axpy(radial * dPhi * cosM[m], ePhi);
+        }
+      }
+    }
+
+  private:
+    size_t order_;
+    // recurrence coefficients, indexed by index(l, m)
+    std::vector<FieldType> a_;
+    std::vector<FieldType> b_;
+
+    size_t index(size_t l, size_t m) const { return l * (order_ + 1) + m; }
+  };
+
+  // row major matrix of size #coils x numberOfMultipoleCoefficients(order), containing the projections of the gradients of the
+  // solid harmonics of the given kind around center onto the coil directions
+  template<class FieldType>
+  std::vector<FieldType> multipoleBasis(const Dune::FieldVector<FieldType, 3>& center, size_t order,
+                                        typename SolidHarmonics<FieldType>::Kind kind,
+                                        const std::vector<Dune::FieldVector<FieldType, 3>>& coilPositions,
+                                        const std::vector<Dune::FieldVector<FieldType, 3>>& coilDirections)
+  {
+    if(coilPositions.size() != coilDirections.size()) {
+      throw std::invalid_argument("number of coil positions and number of coil directions differ");
+    }
+    SolidHarmonics<FieldType> harmonics(order);
+    std::vector<FieldType> basis(coilPositions.size() * harmonics.size());
+    std::vector<Dune::FieldVector<FieldType, 3>> gradients(harmonics.size());
+    for(size_t coil = 0; coil < coilPositions.size(); ++coil) {
+      harmonics.gradients(coilPositions[coil] - center, kind, gradients.data());
+      for(size_t k = 0; k < harmonics.size(); ++k) {
+        basis[coil * harmonics.size() + k] = gradients[k] * coilDirections[coil];
+      }
+    }
+    return basis;
+  }
+
+  // signal space separation basis, i.e. the #coils x (numberOfMultipoleCoefficients(innerOrder) +
+  // numberOfMultipoleCoefficients(outerOrder)) row major matrix whose first columns span the fields of sources inside of a
+  // sphere around center and whose last columns span the fields of sources outside of the sensor array. The inner columns
+  // match the coefficients of MultipoleExpansionMEG, so that its fields are given by the inner basis times its coefficients.
+  template<class FieldType>
+  std::vector<FieldType> signalSpaceSeparationBasis(const Dune::FieldVector<FieldType, 3>& center, size_t innerOrder,
+                                                    size_t outerOrder,
+                                                    const std::vector<Dune::FieldVector<FieldType, 3>>& coilPositions,
+                                                    const std::vector<Dune::FieldVector<FieldType, 3>>& coilDirections)
+  {
+    using Kind = typename SolidHarmonics<FieldType>::Kind;
+    auto inner = multipoleBasis(center, innerOrder, Kind::irregular, coilPositions, coilDirections);
+    auto outer = multipoleBasis(center, outerOrder, Kind::regular, coilPositions, coilDirections);
+    size_t innerSize = numberOfMultipoleCoefficients(innerOrder);
+    size_t outerSize = numberOfMultipoleCoefficients(outerOrder);
+    std::vector<FieldType> basis(coilPositions.size() * (innerSize + outerSize));
+    for(size_t coil = 0; coil < coilPositions.size(); ++coil) {
+      std::copy_n(inner.data() + coil * innerSize, innerSize, basis.data() + coil * (innerSize + outerSize));
+      std::copy_n(outer.data() + coil * outerSize, outerSize, basis.data() + coil * (innerSize + outerSize) + innerSize);
+    }
+    return basis;
+  }
+
+  // truncated multipole expansion of the total field of a set of dipoles in a multilayer sphere model outside of the conductor.
+  //
+  // Outside of the conductor, the total field is the gradient of the scalar potential W of AnalyticSolutionMEG::scalarPotential,
+  // which is harmonic outside of the sphere around the center containing all dipoles. It is expanded into the irregular solid
+  // harmonics up to the given order,
+  //   W = sum_{l, m} c_lm r^-(l+1) P_l^m(cos theta) {cos, sin}(m phi),
+  // where the coefficients are the projections of W onto the spherical harmonics on the sphere of the given radius. They are
+  // computed by a product quadrature with order + 1 Gauss-Legendre points in cos(theta) and 2 * order + 2 uniform points in phi.
+  // Adding N dipoles costs O(N * order^2) evaluations of the scalar potential, every evaluation of the field costs O(order^2),
+  // independent of N. The truncation error decays like (maximum dipole radius / sensor radius)^(order + 1), so the radius of the
+  // expansion should lie between the dipoles and the coils, preferably close to the coils.
+  template<class FieldType>
+  class MultipoleExpansionMEG
+  {
+  public:
+    using Solver = AnalyticSolutionMEG<FieldType>;
+    using Coordinate = typename Solver::Coordinate;
+    using Kind = typename SolidHarmonics<FieldType>::Kind;
+    static constexpr size_t dim = Solver::dim;
+
+    // create an empty expansion of the given order for the sphere model of solver, sampling the potential at the given radius
+    MultipoleExpansionMEG(const Solver& solver, size_t order, FieldType radius)
+      : solver_(solver)
+      , harmonics_(order)
+      , radius_(radius)
+      , coefficients_(harmonics_.size(), 0.0)
+    {
+      if(!(radius > 0.0)) {
+        throw std::invalid_argument("the radius of the multipole expansion has to be positive");
+      }
+      gaussLegendre(order + 1, nodes_, weights_);
+      // quadrature points on the sphere, ring by ring
+      const size_t pointsPerRing = 2 * order + 2;
+      for(size_t i = 0; i < nodes_.size(); ++i) {
+        FieldType sinTheta = std::sqrt(std::max<FieldType>(0.0, 1.0 - nodes_[i] * nodes_[i]));
+        for(size_t j = 0; j < pointsPerRing; ++j) {
+          FieldType phi = 2.0 * M_PI * j / pointsPerRing;
+          Coordinate point = {sinTheta * std::cos(phi), sinTheta * std::sin(phi), nodes_[i]};
+          point *= radius_;
+          point += solver_.sphereCenter();
+          points_.push_back(point);
+        }
+      }
+    }
+
+    // add the dipoles to the expansion, distributing them over numberOfThreads threads, where 0 means one thread per hardware
+    // thread. All dipoles have to lie inside of the sphere of the expansion.
+    void addDipoles(const std::vector<Dipole<FieldType, dim>>& dipoles, size_t numberOfThreads = 0)
+    {
+      for(size_t i = 0; i < dipoles.size(); ++i) {
+        checkInside(dipoles[i].position(), "dipole " + std::to_string(i));
+      }
+
+      // potentials at the quadrature points, accumulated per thread
+      std::vector<Solver> solvers(resolveNumberOfThreads(numberOfThreads), solver_);
+      std::vector<std::vector<FieldType>> potentials(solvers.size(), std::vector<FieldType>(points_.size(), 0.0));
+      parallelForBlocks(dipoles.size(), 16, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t threadIndex) {
+        auto& solver = solvers[threadIndex];
+        auto& potential = potentials[threadIndex];
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+          solver.bind(dipoles[i]);
+          for(size_t k = 0; k < points_.size(); ++k) {
+            potential[k] += solver.scalarPotential(points_[k]);
+          }
+        }
+      });
+      for(size_t thread = 1; thread < potentials.size(); ++thread) {
+        for(size_t k = 0; k < points_.size(); ++k) {
+          potentials[0][k] += potentials[thread][k];
+        }
+      }
+      project(potentials[0]);
+    }
+
+    void addDipole(const Dipole<FieldType, dim>& dipole)
+    {
+      addDipoles({dipole}, 1);
+    }
+
+    // add the dipole bound to solver, which has to use the same sphere center as this expansion
+    void addBoundDipole(const Solver& solver)
+    {
+      if(!(solver.sphereCenter() == solver_.sphereCenter())) {
+        throw std::invalid_argument("solver and multipole expansion use different sphere centers");
+      }
+      std::vector<FieldType> potential(points_.size());
+      for(size_t k = 0; k < points_.size(); ++k) {
+        potential[k] = solver.scalarPotential(points_[k]);
+      }
+      project(potential);
+    }
+
+    void clear()
+    {
+      std::fill(coefficients_.begin(), coefficients_.end(), 0.0);
+    }
+
+    // coefficients c_lm, ordered as in multipoleIndex
+    const std::vector<FieldType>& coefficients() const { return coefficients_; }
+    size_t order() const { return harmonics_.order(); }
+    FieldType radius() const { return radius_; }
+
+    //////////////////////////////////
+    // evaluation of the expansion
+    //////////////////////////////////
+
+    Coordinate totalField(const Coordinate& coilPos) const
+    {
+      std::vector<Coordinate> gradients(harmonics_.size());
+      harmonics_.gradients(coilPos - solver_.sphereCenter(), Kind::irregular, gradients.data());
+      Coordinate field(0.0);
+      for(size_t k = 0; k < gradients.size(); ++k) {
+        field.axpy(coefficients_[k], gradients[k]);
+      }
+      return field;
+    }
+
+    FieldType totalField(const Coordinate& coilPos, const Coordinate& direction) const
+    {
+      return totalField(coilPos) * direction;
+    }
+
+    // fields at all coils, distributing the coils over numberOfThreads threads, where 0 means one thread per hardware thread
+    std::vector<FieldType> totalField(const std::vector<Coordinate>& coilPositions, const std::vector<Coordinate>& directions,
+                                      size_t numberOfThreads = 0) const
+    {
+      if(coilPositions.size() != directions.size()) {
+        throw std::invalid_argument("number of coil positions and number of coil directions differ");
+      }
+      std::vector<FieldType> fields(coilPositions.size());
+      parallelForBlocks(coilPositions.size(), 16, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        for(size_t coil = blockBegin; coil < blockEnd; ++coil) {
+          fields[coil] = totalField(coilPositions[coil], directions[coil]);
+        }
+      });
+      return fields;
+    }
+
+  private:
+    Solver solver_;
+    SolidHarmonics<FieldType> harmonics_;
+    FieldType radius_;
+    std::vector<FieldType> coefficients_;
+    // Gauss-Legendre nodes and weights in cos(theta)
+    std::vector<FieldType> nodes_;
+    std::vector<FieldType> weights_;
+    // quadrature points on the sphere of the expansion, ring by ring
+    std::vector<Coordinate> points_;
+
+    void checkInside(const Coordinate& position, const std::string& name) const
+    {
+      if(!((position - solver_.sphereCenter()).two_norm() < radius_)) {
+        throw std::invalid_argument(name + " does not lie inside of the sphere of the multipole expansion");
+      }
+    }
+
+    // add the projection of the potential given at the quadrature points onto the solid harmonics to the coefficients
+    void project(const std::vector<FieldType>& potential)
+    {
+      const size_t order = harmonics_.order();
+      const size_t pointsPerRing = 2 * order + 2;
+      std::vector<FieldType> p0(order + 1);
+      std::vector<FieldType> q((order + 1) * (order + 1), 0.0);
+      std::vector<FieldType> cosSums(order + 1);
+      std::vector<FieldType> sinSums(order + 1);
+
+      // radius^(l+1) for the irregular harmonics
+      std::vector<FieldType> radialFactors(order + 1);
+      radialFactors[0] = radius_;
+      for(size_t l = 1; l <= order; ++l) {
+        radialFactors[l] = radialFactors[l - 1] * radius_;
+      }
+
+      for(size_t i = 0; i < nodes_.size(); ++i) {
+        FieldType sinTheta = std::sqrt(std::max<FieldType>(0.0, 1.0 - nodes_[i] * nodes_[i]));
+        harmonics_.legendre(nodes_[i], sinTheta, p0.data(), q.data());
+
+        // Fourier sums over the ring
+        for(size_t m = 0; m <= order; ++m) {
+          cosSums[m] = 0.0;
+          sinSums[m] = 0.0;
+          for(size_t j = 0; j < pointsPerRing; ++j) {
+            FieldType phi = 2.0 * M_PI * j / pointsPerRing;
+            cosSums[m] += potential[i * pointsPerRing + j] * std::cos(m * phi);
+            sinSums[m] += potential[i * pointsPerRing + j] * std::sin(m * phi);
+          }
+        }
+
+        // the squared norm of P_l^m {cos, sin}(m phi) on the unit sphere is 4 pi for m = 0 and 2 pi otherwise
+        FieldType ringWeight = weights_[i] * 2.0 * M_PI / pointsPerRing;
+        for(size_t l = 1; l <= order; ++l) {
+          FieldType scale = ringWeight * radialFactors[l];
+          coefficients_[multipoleIndex(l, 0, false)] += scale * p0[l] * cosSums[0] / (4.0 * M_PI);
+          for(size_t m = 1; m <= l; ++m) {
+            FieldType p = sinTheta * q[l * (order + 1) + m];
+            coefficients_[multipoleIndex(l, m, false)] += scale * p * cosSums[m] / (2.0 * M_PI);
+            coefficients_[multipoleIndex(l, m, true)] += scale * p * sinSums[m] / (2.0 * M_PI);
+          }
+        }
+      }
+    }
+
+    // nodes and weights of the Gauss-Legendre rule with n points on [-1, 1], computed by Newton's method
+    static void gaussLegendre(size_t n, std::vector<FieldType>& nodes, std::vector<FieldType>& weights)
+    {
+      nodes.resize(n);
+      weights.resize(n);
+      for(size_t i = 0; i < n; ++i) {
+        FieldType x = std::cos(M_PI * (i + 0.75) / (n + 0.5));
+        FieldType derivative = 1.0;
+        for(size_t iteration = 0; iteration < 100; ++iteration) {
+          // Legendre polynomial of degree n and its derivative at x
+          FieldType p = 1.0;
+          FieldType previous = 0.0;
+          for(size_t k = 1; k <= n; ++k) {
+            FieldType next = ((2.0 * k - 1.0) * x * p - (k - 1.0) * previous) / k;
+            previous = p;
+            p = next;
+          }
+          derivative = n * (x * p - previous) / (x * x - 1.0);
+          FieldType step = p / derivative;
+          x -= step;
+          if(std::abs(step) < 1e-15) {
+            break;
+          }
+        }
+        nodes[i] = x;
+        weights[i] = 2.0 / ((1.0 - x * x) * derivative * derivative);
+      }
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_MULTIPOLE_EXPANSION_HH
@@ -0,0 +1,87 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_PARALLEL_HH
+#define DUNEURO_ANALYTIC_SOLUTION_PARALLEL_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <dune/duneuro-analytic-solution/tracing.hh>
+
+namespace duneuro {
+
+  // number of threads used by the batched methods if the caller passes 0
+  inline size_t defaultNumberOfThreads()
+  {
+    size_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 0 ? hardwareThreads : 1;
+  }
+
+  // number of threads used for a requested number of threads, where 0 means one thread per hardware thread
+  inline size_t resolveNumberOfThreads(size_t numberOfThreads)
+  {
+    return numberOfThreads > 0 ? numberOfThreads : defaultNumberOfThreads();
+  }
+
+  // split [0, size) into blocks of at most blockSize entries and call func(blockBegin, blockEnd, threadIndex) for every block.
+  // Blocks are handed out dynamically, so that threads which finish early pick up the remaining work. If numberOfThreads is 0,
+  // defaultNumberOfThreads() threads are used. An exception thrown by func is rethrown in the calling thread. Returns the number
+  // of threads that were actually used.
+  template<class Function>
+  size_t parallelForBlocks(size_t size, size_t blockSize, size_t numberOfThreads, Function&& func)
+  {
+    if(size == 0) {
+      return 0;
+    }
+    blockSize = std::max<size_t>(blockSize, 1);
+    size_t numberOfBlocks = (size + blockSize - 1) / blockSize;
+    numberOfThreads = std::min(resolveNumberOfThreads(numberOfThreads), numberOfBlocks);
+
+    std::atomic<size_t> nextBlock(0);
+    std::exception_ptr exception;
+    std::mutex exceptionMutex;
+
+    auto worker = [&](size_t threadIndex) {
+      TraceSpan span("worker", "schedule");
+      try {
+        for(size_t block = nextBlock++; block < numberOfBlocks; block = nextBlock++) {
+          size_t blockBegin = block * blockSize;
+          size_t blockEnd = std::min(blockBegin + blockSize, size);
+          func(blockBegin, blockEnd, threadIndex);
+        }
+      }
+      catch(...) {
+        std::lock_guard<std::mutex> lock(exceptionMutex);
+        if(!exception) {
+          exception = std::current_exception();
+        }
+        // make the other threads stop after their current block
+        nextBlock = numberOfBlocks;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numberOfThreads - 1);
+    for(size_t i = 1; i < numberOfThreads; ++i) {
+      // new threads record to the trace track of their index, the calling thread keeps its own track
+      threads.emplace_back([&worker, i]() {
+        TraceRecorder::setThreadIndex(i);
+        worker(i);
+      });
+    }
+    worker(0);
+    for(auto& thread : threads) {
+      thread.join();
+    }
+
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
+    return numberOfThreads;
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_PARALLEL_HH
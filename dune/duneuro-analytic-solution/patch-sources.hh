@@ -0,0 +1,165 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_PATCH_SOURCES_HH
+#define DUNEURO_ANALYTIC_SOLUTION_PATCH_SOURCES_HH
+
+#include <dune/common/fvector.hh>
+#include <dune/geometry/quadraturerules.hh>
+#include <dune/geometry/type.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <dune/duneuro-analytic-solution/tracing.hh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace duneuro {
+
+  // extended sources given by patches of a triangulated surface, e.g. the cortex, carrying a uniform current density of unit
+  // strength along the surface normal, discretized by quadrature points. Every quadrature point is a dipole whose moment is the
+  // quadrature weight times the normal of its triangle, scaled by the area of the triangle, so that the field of a patch is the
+  // sum of the fields of its quadrature points.
+  template<class FieldType>
+  struct PatchQuadrature {
+    static constexpr size_t dim = 3;
+    using Coordinate = Dune::FieldVector<FieldType, dim>;
+
+    // the quadrature points of patch p are offsets[p], ..., offsets[p + 1] - 1
+    std::vector<size_t> offsets;
+    std::vector<Coordinate> positions;
+    std::vector<Coordinate> moments;
+
+    size_t numberOfPatches() const
+    {
+      return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+  };
+
+  // discretize the patches of the triangles, where triangle t with vertices triangles[t] belongs to patch patchIndices[t], or to
+  // patch t if patchIndices is empty. The normals follow the orientation of the vertices. Every triangle is integrated with the
+  // Dune quadrature rule of the given order on the reference triangle. Since the field varies on the scale of the distance to
+  // the sensors, a triangle whose centroid is closer to a sensor than refinementFactor times its longest edge is split into four
+  // triangles at its edge midpoints, recursively up to maximumRefinementLevel times. The triangles are distributed in blocks over
+  // numberOfThreads threads, where 0 means one thread per hardware thread. Throws if a vertex index is out of range or the
+  // numbers of triangles and patch indices differ.
+  template<class FieldType>
+  PatchQuadrature<FieldType> makePatchQuadrature(const std::vector<Dune::FieldVector<FieldType, 3>>& vertices,
+                                                 const std::vector<std::array<size_t, 3>>& triangles,
+                                                 const std::vector<size_t>& patchIndices,
+                                                 const std::vector<Dune::FieldVector<FieldType, 3>>& sensorPositions,
+                                                 int quadratureOrder = 2, FieldType refinementFactor = 2.0,
+                                                 size_t maximumRefinementLevel = 4, size_t numberOfThreads = 0)
+  {
+    using Coordinate = Dune::FieldVector<FieldType, 3>;
+    // number of triangles a thread processes at once
+    constexpr size_t blockSize = 256;
+
+    TraceSpan span("makePatchQuadrature", "job");
+    if(!patchIndices.empty() && patchIndices.size() != triangles.size()) {
+      throw std::invalid_argument("number of triangles and number of patch indices differ");
+    }
+    for(const auto& triangle : triangles) {
+      for(size_t vertex : triangle) {
+        if(vertex >= vertices.size()) {
+          throw std::invalid_argument("vertex index of a triangle out of range");
+        }
+      }
+    }
+    const auto& rule = Dune::QuadratureRules<FieldType, 2>::rule(Dune::GeometryTypes::triangle, quadratureOrder);
+
+    // triangles ordered by patch, such that the quadrature points of a patch are contiguous
+    const size_t numberOfPatches = patchIndices.empty() ? triangles.size() : *std::max_element(patchIndices.begin(), patchIndices.end()) + 1;
+    PatchQuadrature<FieldType> quadrature;
+    quadrature.offsets.assign(numberOfPatches + 1, 0);
+    std::vector<size_t> triangleOrder(triangles.size());
+    {
+      std::vector<size_t> patchBegin(numberOfPatches + 1, 0);
+      for(size_t t = 0; t < triangles.size(); ++t) {
+        ++patchBegin[(patchIndices.empty() ? t : patchIndices[t]) + 1];
+      }
+      for(size_t p = 0; p < numberOfPatches; ++p) {
+        patchBegin[p + 1] += patchBegin[p];
+      }
+      for(size_t t = 0; t < triangles.size(); ++t) {
+        triangleOrder[patchBegin[patchIndices.empty() ? t : patchIndices[t]]++] = t;
+      }
+    }
+
+    auto distanceToSensors = [&](const Coordinate& point) {
+      FieldType distance2 = std::numeric_limits<FieldType>::infinity();
+      for(const auto& sensor : sensorPositions) {
+        distance2 = std::min(distance2, (point - sensor).two_norm2());
+      }
+      return std::sqrt(distance2);
+    };
+
+    // quadrature points of every block of ordered triangles, and the number of points of every triangle
+    const size_t numberOfBlocks = (triangles.size() + blockSize - 1) / blockSize;
+    std::vector<std::vector<Coordinate>> blockPositions(numberOfBlocks);
+    std::vector<std::vector<Coordinate>> blockMoments(numberOfBlocks);
+    std::vector<size_t> pointsPerTriangle(triangles.size());
+    parallelForBlocks(triangles.size(), blockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+      auto& positions = blockPositions[blockBegin / blockSize];
+      auto& moments = blockMoments[blockBegin / blockSize];
+      // triangles still to integrate, with their refinement level
+      std::vector<std::pair<std::array<Coordinate, 3>, size_t>> stack;
+      for(size_t k = blockBegin; k < blockEnd; ++k) {
+        const auto& triangle = triangles[triangleOrder[k]];
+        const size_t pointsBefore = positions.size();
+        stack.push_back({{vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]]}, 0});
+        while(!stack.empty()) {
+          auto [corners, level] = stack.back();
+          stack.pop_back();
+          if(level < maximumRefinementLevel) {
+            FieldType longestEdge = std::max({(corners[1] - corners[0]).two_norm(), (corners[2] - corners[1]).two_norm(), (corners[0] - corners[2]).two_norm()});
+            Coordinate centroid = corners[0] + corners[1] + corners[2];
+            centroid /= 3.0;
+            if(distanceToSensors(centroid) < refinementFactor * longestEdge) {
+              Coordinate m01 = corners[0] + corners[1];
+              Coordinate m12 = corners[1] + corners[2];
+              Coordinate m20 = corners[2] + corners[0];
+              m01 *= 0.5;
+              m12 *= 0.5;
+              m20 *= 0.5;
+              stack.push_back({{corners[0], m01, m20}, level + 1});
+              stack.push_back({{m01, corners[1], m12}, level + 1});
+              stack.push_back({{m20, m12, corners[2]}, level + 1});
+              stack.push_back({{m12, m20, m01}, level + 1});
+              continue;
+            }
+          }
+          Coordinate e1 = corners[1] - corners[0];
+          Coordinate e2 = corners[2] - corners[0];
+          // normal of length twice the area, matching the reference triangle of area 1/2
+          Coordinate normal = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+          for(const auto& point : rule) {
+            Coordinate position = corners[0];
+            position.axpy(point.position()[0], e1);
+            position.axpy(point.position()[1], e2);
+            positions.push_back(position);
+            moments.push_back(point.weight() * normal);
+          }
+        }
+        pointsPerTriangle[k] = positions.size() - pointsBefore;
+      }
+    });
+
+    for(size_t k = 0; k < triangles.size(); ++k) {
+      quadrature.offsets[(patchIndices.empty() ? triangleOrder[k] : patchIndices[triangleOrder[k]]) + 1] += pointsPerTriangle[k];
+    }
+    for(size_t p = 0; p < numberOfPatches; ++p) {
+      quadrature.offsets[p + 1] += quadrature.offsets[p];
+    }
+    quadrature.positions.reserve(quadrature.offsets.back());
+    quadrature.moments.reserve(quadrature.offsets.back());
+    for(size_t block = 0; block < numberOfBlocks; ++block) {
+      quadrature.positions.insert(quadrature.positions.end(), blockPositions[block].begin(), blockPositions[block].end());
+      quadrature.moments.insert(quadrature.moments.end(), blockMoments[block].begin(), blockMoments[block].end());
+    }
+    return quadrature;
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_PATCH_SOURCES_HH
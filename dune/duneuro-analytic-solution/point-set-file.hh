@@ -0,0 +1,221 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_POINT_SET_FILE_HH
+#define DUNEURO_ANALYTIC_SOLUTION_POINT_SET_FILE_HH
+
+#include <dune/common/fvector.hh>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace duneuro {
+
+  // binary file of a set of points, e.g. the dipole positions of a source space or the coils of a sensor array, which is mapped
+  // into memory and used in place. The file consists of a 64 byte header followed by numberOfArrays arrays of count scalars
+  // of scalarSize bytes, namely the x-, y- and z-coordinates of the positions and, if numberOfArrays is 6, the x-, y- and
+  // z-coordinates of a direction per point, e.g. coil directions or dipole moments. Every array starts at a multiple of 64 bytes,
+  // the gaps being filled with zeros, such that array k starts at 64 + k * pointSetArrayStride(count, scalarSize). Scalars are float32
+  // or float64 and all fields are stored in native byte order.
+  struct PointSetFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t scalarSize;
+    uint64_t count;
+    uint32_t numberOfArrays;
+    uint32_t reserved0;
+    uint64_t reserved[4];
+  };
+  static_assert(sizeof(PointSetFileHeader) == 64, "point set file header has to be 64 bytes");
+
+  constexpr uint32_t pointSetFileVersion = 1;
+
+  inline const char* pointSetFileMagic()
+  {
+    return "DAPOINTS";
+  }
+
+  // distance of consecutive arrays in a point set file in bytes
+  inline uint64_t pointSetArrayStride(uint64_t count, uint64_t scalarSize)
+  {
+    return (count * scalarSize + 63) / 64 * 64;
+  }
+
+  // check that numberOfArrays arrays of count scalars of scalarSize bytes fit into a point set file of fileSize bytes. count
+  // is compared by division first, so that the products cannot overflow for a corrupt header.
+  inline bool pointSetArraysFit(uint64_t fileSize, uint64_t count, uint64_t scalarSize, uint64_t numberOfArrays)
+  {
+    if(fileSize < sizeof(PointSetFileHeader) || scalarSize == 0 || numberOfArrays == 0) {
+      return false;
+    }
+    const uint64_t arraysSize = fileSize - sizeof(PointSetFileHeader);
+    return count <= arraysSize / numberOfArrays / scalarSize
+      && numberOfArrays * pointSetArrayStride(count, scalarSize) <= arraysSize;
+  }
+
+  // read only view of the arrays of a point set file, kept alive by an owner. Element access converts the stored scalars to
+  // FieldType, so that lead field builders gather the points of a block directly from the mapping.
+  template<class FieldType>
+  class PointSetView
+  {
+  public:
+    static constexpr size_t dim = 3;
+    using Coordinate = Dune::FieldVector<FieldType, dim>;
+
+    PointSetView(std::shared_ptr<const void> owner, std::array<const void*, 2 * dim> arrays, size_t scalarSize, size_t count,
+                 bool hasDirections)
+      : owner_(std::move(owner))
+      , arrays_(arrays)
+      , scalarSize_(scalarSize)
+      , count_(count)
+      , hasDirections_(hasDirections)
+    {
+    }
+
+    size_t size() const { return count_; }
+    bool hasDirections() const { return hasDirections_; }
+    size_t scalarSize() const { return scalarSize_; }
+
+    Coordinate operator[](size_t i) const
+    {
+      return point(0, i);
+    }
+
+    // throws if the file has no directions
+    Coordinate direction(size_t i) const
+    {
+      if(!hasDirections_) {
+        throw std::invalid_argument("point set has no directions");
+      }
+      return point(dim, i);
+    }
+
+    // view of the points begin, ..., end - 1, sharing the owner
+    PointSetView subset(size_t begin, size_t end) const
+    {
+      if(begin > end || end > count_) {
+        throw std::invalid_argument("subset of a point set out of range");
+      }
+      std::array<const void*, 2 * dim> arrays = {};
+      for(size_t k = 0; k < (hasDirections_ ? 2 * dim : dim); ++k) {
+        arrays[k] = static_cast<const char*>(arrays_[k]) + begin * scalarSize_;
+      }
+      return PointSetView(owner_, arrays, scalarSize_, end - begin, hasDirections_);
+    }
+
+    // copies of the positions and directions, e.g. for the few hundred coils of a sensor array
+    std::vector<Coordinate> positions() const
+    {
+      std::vector<Coordinate> result(count_);
+      for(size_t i = 0; i < count_; ++i) {
+        result[i] = point(0, i);
+      }
+      return result;
+    }
+
+    std::vector<Coordinate> directions() const
+    {
+      std::vector<Coordinate> result(count_);
+      for(size_t i = 0; i < count_; ++i) {
+        result[i] = direction(i);
+      }
+      return result;
+    }
+
+  private:
+    Coordinate point(size_t firstArray, size_t i) const
+    {
+      Coordinate result;
+      for(size_t j = 0; j < dim; ++j) {
+        result[j] = scalarSize_ == sizeof(double) ? static_cast<FieldType>(static_cast<const double*>(arrays_[firstArray + j])[i])
+                                                  : static_cast<FieldType>(static_cast<const float*>(arrays_[firstArray + j])[i]);
+      }
+      return result;
+    }
+
+    std::shared_ptr<const void> owner_;
+    std::array<const void*, 2 * dim> arrays_;
+    size_t scalarSize_;
+    size_t count_;
+    bool hasDirections_;
+  };
+
+  // map a point set file into memory. Throws if the file cannot be read or is not a valid point set file.
+  template<class FieldType>
+  PointSetView<FieldType> mapPointSetFile(const std::string& filename)
+  {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+      throw std::runtime_error("could not open point set file " + filename);
+    }
+    struct stat status;
+    PointSetFileHeader header;
+    bool valid = ::fstat(fd, &status) == 0
+      && ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+      && std::memcmp(header.magic, pointSetFileMagic(), sizeof(header.magic)) == 0
+      && header.version == pointSetFileVersion
+      && (header.scalarSize == sizeof(float) || header.scalarSize == sizeof(double))
+      && (header.numberOfArrays == 3 || header.numberOfArrays == 6)
+      && pointSetArraysFit(status.st_size, header.count, header.scalarSize, header.numberOfArrays);
+    if(!valid) {
+      ::close(fd);
+      throw std::invalid_argument(filename + " is not a valid point set file");
+    }
+
+    size_t length = status.st_size;
+    void* address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(address == MAP_FAILED) {
+      throw std::runtime_error("could not map point set file " + filename);
+    }
+    std::shared_ptr<const void> owner(address, [length](const void* pointer) { ::munmap(const_cast<void*>(pointer), length); });
+    std::array<const void*, 6> arrays = {};
+    for(size_t k = 0; k < header.numberOfArrays; ++k) {
+      arrays[k] = static_cast<const char*>(address) + sizeof(PointSetFileHeader) + k * pointSetArrayStride(header.count, header.scalarSize);
+    }
+    return PointSetView<FieldType>(owner, arrays, header.scalarSize, header.count, header.numberOfArrays == 6);
+  }
+
+  // write the positions and, if not empty, the directions into a point set file with scalars of type StorageType, i.e. float
+  // or double. Throws if the numbers of positions and directions differ or the file cannot be written.
+  template<class StorageType, class FieldType>
+  void writePointSetFile(const std::string& filename, const std::vector<Dune::FieldVector<FieldType, 3>>& positions,
+                         const std::vector<Dune::FieldVector<FieldType, 3>>& directions = {})
+  {
+    static_assert(sizeof(StorageType) == sizeof(float) || sizeof(StorageType) == sizeof(double), "point sets store float or double");
+    if(!directions.empty() && directions.size() != positions.size()) {
+      throw std::invalid_argument("number of positions and number of directions differ");
+    }
+    PointSetFileHeader header = {};
+    std::memcpy(header.magic, pointSetFileMagic(), sizeof(header.magic));
+    header.version = pointSetFileVersion;
+    header.scalarSize = sizeof(StorageType);
+    header.count = positions.size();
+    header.numberOfArrays = directions.empty() ? 3 : 6;
+
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<StorageType> array(pointSetArrayStride(header.count, header.scalarSize) / sizeof(StorageType), StorageType(0));
+    for(size_t k = 0; k < header.numberOfArrays; ++k) {
+      const auto& points = k < 3 ? positions : directions;
+      for(size_t i = 0; i < points.size(); ++i) {
+        array[i] = static_cast<StorageType>(points[i][k % 3]);
+      }
+      output.write(reinterpret_cast<const char*>(array.data()), array.size() * sizeof(StorageType));
+    }
+    output.close();
+    if(!output) {
+      throw std::runtime_error("could not write point set file " + filename);
+    }
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_POINT_SET_FILE_HH
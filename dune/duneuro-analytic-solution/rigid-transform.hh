@@ -0,0 +1,78 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_RIGID_TRANSFORM_HH
+#define DUNEURO_ANALYTIC_SOLUTION_RIGID_TRANSFORM_HH
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <cmath>
+#include <stdexcept>
+
+namespace duneuro {
+
+  // rigid transformation x -> rotation * x + translation, e.g. a head pose mapping head coordinates to device coordinates
+  template<class FieldType>
+  struct RigidTransform {
+    static constexpr size_t dim = 3;
+    using Coordinate = Dune::FieldVector<FieldType, dim>;
+    using Matrix = Dune::FieldMatrix<FieldType, dim, dim>;
+
+    Matrix rotation;
+    Coordinate translation;
+
+    RigidTransform()
+      : rotation({{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}})
+      , translation(0.0)
+    {
+    }
+
+    // throws if rotation is not orthogonal with determinant 1 up to tolerance
+    RigidTransform(const Matrix& rotation_, const Coordinate& translation_, FieldType tolerance = 1e-6)
+      : rotation(rotation_)
+      , translation(translation_)
+    {
+      for(size_t i = 0; i < dim; ++i) {
+        for(size_t j = 0; j < dim; ++j) {
+          if(std::abs(rotation[i] * rotation[j] - (i == j ? 1.0 : 0.0)) > tolerance) {
+            throw std::invalid_argument("rotation of a rigid transform is not orthogonal");
+          }
+        }
+      }
+      FieldType determinant = rotation[0][0] * (rotation[1][1] * rotation[2][2] - rotation[1][2] * rotation[2][1])
+        - rotation[0][1] * (rotation[1][0] * rotation[2][2] - rotation[1][2] * rotation[2][0])
+        + rotation[0][2] * (rotation[1][0] * rotation[2][1] - rotation[1][1] * rotation[2][0]);
+      if(determinant < 0.0) {
+        throw std::invalid_argument("rotation of a rigid transform is a reflection");
+      }
+    }
+
+    Coordinate applyToPosition(const Coordinate& position) const
+    {
+      Coordinate result;
+      rotation.mv(position, result);
+      result += translation;
+      return result;
+    }
+
+    Coordinate applyToDirection(const Coordinate& direction) const
+    {
+      Coordinate result;
+      rotation.mv(direction, result);
+      return result;
+    }
+
+    Coordinate applyInverseToPosition(const Coordinate& position) const
+    {
+      Coordinate result;
+      rotation.mtv(position - translation, result);
+      return result;
+    }
+
+    Coordinate applyInverseToDirection(const Coordinate& direction) const
+    {
+      Coordinate result;
+      rotation.mtv(direction, result);
+      return result;
+    }
+  };
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_RIGID_TRANSFORM_HH
@@ -0,0 +1,263 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_SPHERE_FIT_HH
+#define DUNEURO_ANALYTIC_SOLUTION_SPHERE_FIT_HH
+
+#include <dune/common/fvector.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <dune/duneuro-analytic-solution/tracing.hh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace duneuro {
+
+  // least squares fit of a sphere to points, e.g. a digitized head shape or the vertices of a scalp mesh, to set up the sphere
+  // center of AnalyticSolutionMEG or the per-coil centers of a local sphere model
+
+  template<class FieldType>
+  struct SphereFit {
+    Dune::FieldVector<FieldType, 3> center;
+    FieldType radius;
+    // root mean square of the distances of the inliers to the sphere
+    FieldType rmsResidual;
+    size_t numberOfInliers;
+  };
+
+  // solve the 4 x 4 system matrix * x = rhs by Gaussian elimination with partial pivoting. Throws if the system is singular,
+  // i.e. the points lie on a plane or a line.
+  template<class FieldType>
+  std::array<FieldType, 4> solveSphereFitSystem(std::array<std::array<FieldType, 4>, 4> matrix, std::array<FieldType, 4> rhs)
+  {
+    FieldType scale = 0.0;
+    for(const auto& row : matrix) {
+      for(FieldType entry : row) {
+        scale = std::max(scale, std::abs(entry));
+      }
+    }
+    for(size_t column = 0; column < 4; ++column) {
+      size_t pivot = column;
+      for(size_t row = column + 1; row < 4; ++row) {
+        if(std::abs(matrix[row][column]) > std::abs(matrix[pivot][column])) {
+          pivot = row;
+        }
+      }
+      if(!(std::abs(matrix[pivot][column]) > 1e-14 * scale)) {
+        throw std::invalid_argument("the points do not determine a sphere");
+      }
+      std::swap(matrix[column], matrix[pivot]);
+      std::swap(rhs[column], rhs[pivot]);
+      for(size_t row = column + 1; row < 4; ++row) {
+        FieldType factor = matrix[row][column] / matrix[column][column];
+        for(size_t j = column; j < 4; ++j) {
+          matrix[row][j] -= factor * matrix[column][j];
+        }
+        rhs[row] -= factor * rhs[column];
+      }
+    }
+    std::array<FieldType, 4> solution;
+    for(size_t row = 4; row-- > 0;) {
+      solution[row] = rhs[row];
+      for(size_t j = row + 1; j < 4; ++j) {
+        solution[row] -= matrix[row][j] * solution[j];
+      }
+      solution[row] /= matrix[row][row];
+    }
+    return solution;
+  }
+
+  // fit a sphere to the points whose inlier flag is set. The algebraic fit |p - o|^2 = 2 c * (p - o) + r^2 - |c|^2, which is
+  // linear in c and r^2 - |c|^2, with the points shifted by their mean o for conditioning, gives the starting point of a few
+  // Gauss-Newton steps minimizing the sum of squared distances | |p - c| - r |. The sums are accumulated in blocks over
+  // numberOfThreads threads, where 0 means one thread per hardware thread.
+  template<class FieldType>
+  SphereFit<FieldType> fitSphere(const std::vector<Dune::FieldVector<FieldType, 3>>& points, const std::vector<char>& inliers,
+                                 size_t numberOfThreads)
+  {
+    using Coordinate = Dune::FieldVector<FieldType, 3>;
+    using Matrix = std::array<std::array<FieldType, 4>, 4>;
+    using Vector = std::array<FieldType, 4>;
+    const size_t blockSize = 4096;
+    const size_t numberOfAccumulators = resolveNumberOfThreads(numberOfThreads);
+
+    // mean of the inliers
+    std::vector<Coordinate> partialMeans(numberOfAccumulators, Coordinate(0.0));
+    std::vector<size_t> partialCounts(numberOfAccumulators, 0);
+    parallelForBlocks(points.size(), blockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t threadIndex) {
+      for(size_t i = blockBegin; i < blockEnd; ++i) {
+        if(inliers[i]) {
+          partialMeans[threadIndex] += points[i];
+          ++partialCounts[threadIndex];
+        }
+      }
+    });
+    Coordinate origin(0.0);
+    size_t numberOfInliers = 0;
+    for(size_t t = 0; t < numberOfAccumulators; ++t) {
+      origin += partialMeans[t];
+      numberOfInliers += partialCounts[t];
+    }
+    if(numberOfInliers < 4) {
+      throw std::invalid_argument("at least 4 points are needed to fit a sphere");
+    }
+    origin /= numberOfInliers;
+
+    // accumulate the normal equations of one step, with row(p) returning the row of the design matrix and the right hand side
+    auto accumulate = [&](auto row) {
+      std::vector<Matrix> partialMatrices(numberOfAccumulators, Matrix{});
+      std::vector<Vector> partialRhs(numberOfAccumulators, Vector{});
+      parallelForBlocks(points.size(), blockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t threadIndex) {
+        Matrix& matrix = partialMatrices[threadIndex];
+        Vector& rhs = partialRhs[threadIndex];
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+          if(!inliers[i]) {
+            continue;
+          }
+          Vector a;
+          FieldType b;
+          row(points[i] - origin, a, b);
+          for(size_t j = 0; j < 4; ++j) {
+            for(size_t k = 0; k < 4; ++k) {
+              matrix[j][k] += a[j] * a[k];
+            }
+            rhs[j] += a[j] * b;
+          }
+        }
+      });
+      Matrix matrix{};
+      Vector rhs{};
+      for(size_t t = 0; t < numberOfAccumulators; ++t) {
+        for(size_t j = 0; j < 4; ++j) {
+          for(size_t k = 0; k < 4; ++k) {
+            matrix[j][k] += partialMatrices[t][j][k];
+          }
+          rhs[j] += partialRhs[t][j];
+        }
+      }
+      return solveSphereFitSystem(matrix, rhs);
+    };
+
+    // algebraic fit in coordinates relative to origin
+    Vector algebraic = accumulate([](const Coordinate& p, Vector& a, FieldType& b) {
+      a = {2.0 * p[0], 2.0 * p[1], 2.0 * p[2], 1.0};
+      b = p * p;
+    });
+    Coordinate center = {algebraic[0], algebraic[1], algebraic[2]};
+    FieldType radius = std::sqrt(std::max(algebraic[3] + center * center, FieldType(0.0)));
+
+    // geometric refinement, linearizing |p - c| - r in the center and the radius
+    const size_t maximumIterations = 20;
+    for(size_t iteration = 0; iteration < maximumIterations; ++iteration) {
+      Vector step = accumulate([&](const Coordinate& p, Vector& a, FieldType& b) {
+        Coordinate difference = p - center;
+        FieldType distance = difference.two_norm();
+        if(distance > 0.0) {
+          difference /= distance;
+        }
+        a = {difference[0], difference[1], difference[2], 1.0};
+        b = distance - radius;
+      });
+      for(size_t j = 0; j < 3; ++j) {
+        center[j] += step[j];
+      }
+      radius += step[3];
+      if(std::sqrt(step[0] * step[0] + step[1] * step[1] + step[2] * step[2] + step[3] * step[3]) <= 1e-12 * radius) {
+        break;
+      }
+    }
+
+    std::vector<FieldType> partialSquares(numberOfAccumulators, 0.0);
+    parallelForBlocks(points.size(), blockSize, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t threadIndex) {
+      for(size_t i = blockBegin; i < blockEnd; ++i) {
+        if(inliers[i]) {
+          FieldType residual = (points[i] - origin - center).two_norm() - radius;
+          partialSquares[threadIndex] += residual * residual;
+        }
+      }
+    });
+    FieldType sumOfSquares = 0.0;
+    for(FieldType partial : partialSquares) {
+      sumOfSquares += partial;
+    }
+
+    SphereFit<FieldType> fit;
+    fit.center = center + origin;
+    fit.radius = radius;
+    fit.rmsResidual = std::sqrt(sumOfSquares / numberOfInliers);
+    fit.numberOfInliers = numberOfInliers;
+    return fit;
+  }
+
+  // fit a sphere to all points. If trimFraction is positive, the fit is repeated on the points whose distance to the previous
+  // sphere is among the (1 - trimFraction) smallest, until the set of inliers no longer changes, such that outliers like the
+  // nose or electrode leads do not pull the sphere. Throws if there are not enough points or they do not determine a sphere.
+  template<class FieldType>
+  SphereFit<FieldType> fitSphere(const std::vector<Dune::FieldVector<FieldType, 3>>& points, FieldType trimFraction = 0.0,
+                                 size_t numberOfThreads = 0)
+  {
+    TraceSpan span("fitSphere", "job");
+    if(!(trimFraction >= 0.0 && trimFraction < 1.0)) {
+      throw std::invalid_argument("the trim fraction has to lie in [0, 1)");
+    }
+    std::vector<char> inliers(points.size(), 1);
+    SphereFit<FieldType> fit = fitSphere(points, inliers, numberOfThreads);
+    if(trimFraction == 0.0) {
+      return fit;
+    }
+
+    const size_t numberOfKept = std::max<size_t>(4, static_cast<size_t>(std::ceil((1.0 - trimFraction) * points.size())));
+    const size_t maximumIterations = 20;
+    std::vector<FieldType> residuals(points.size());
+    std::vector<FieldType> sortedResiduals;
+    for(size_t iteration = 0; iteration < maximumIterations; ++iteration) {
+      parallelForBlocks(points.size(), 4096, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+          residuals[i] = std::abs((points[i] - fit.center).two_norm() - fit.radius);
+        }
+      });
+      sortedResiduals = residuals;
+      std::nth_element(sortedResiduals.begin(), sortedResiduals.begin() + (numberOfKept - 1), sortedResiduals.end());
+      const FieldType threshold = sortedResiduals[numberOfKept - 1];
+      bool changed = false;
+      for(size_t i = 0; i < points.size(); ++i) {
+        char inlier = residuals[i] <= threshold;
+        changed = changed || inlier != inliers[i];
+        inliers[i] = inlier;
+      }
+      if(!changed) {
+        break;
+      }
+      fit = fitSphere(points, inliers, numberOfThreads);
+    }
+    return fit;
+  }
+
+  // fit one sphere per sensor to the points within neighbourhoodRadius of the sensor position, as for the local sphere models
+  // of localSphereLeadField. The sensors are distributed over numberOfThreads threads, each fit running single threaded.
+  // Throws if the points near a sensor do not determine a sphere.
+  template<class FieldType>
+  std::vector<SphereFit<FieldType>> fitLocalSpheres(const std::vector<Dune::FieldVector<FieldType, 3>>& points,
+                                                    const std::vector<Dune::FieldVector<FieldType, 3>>& sensorPositions,
+                                                    FieldType neighbourhoodRadius, FieldType trimFraction = 0.0,
+                                                    size_t numberOfThreads = 0)
+  {
+    TraceSpan span("fitLocalSpheres", "job");
+    std::vector<SphereFit<FieldType>> fits(sensorPositions.size());
+    const FieldType squaredRadius = neighbourhoodRadius * neighbourhoodRadius;
+    parallelForBlocks(sensorPositions.size(), 1, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t) {
+      for(size_t sensor = blockBegin; sensor < blockEnd; ++sensor) {
+        std::vector<Dune::FieldVector<FieldType, 3>> neighbours;
+        for(const auto& point : points) {
+          if((point - sensorPositions[sensor]).two_norm2() <= squaredRadius) {
+            neighbours.push_back(point);
+          }
+        }
+        fits[sensor] = fitSphere(neighbours, trimFraction, 1);
+      }
+    });
+    return fits;
+  }
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_SPHERE_FIT_HH
@@ -0,0 +1,286 @@
+#ifndef DUNEURO_ANALYTIC_SOLUTION_TRACING_HH
+#define DUNEURO_ANALYTIC_SOLUTION_TRACING_HH
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// set to 1 (e.g. by configuring with -DDUNEURO_ANALYTIC_SOLUTION_TRACING=ON) to let the multi-threaded methods record
+// timeline spans, which can be written as a Chrome trace (chrome://tracing, https://ui.perfetto.dev). If disabled, all spans
+// are empty objects and optimized away.
+#ifndef DUNEURO_ANALYTIC_SOLUTION_TRACING
+#define DUNEURO_ANALYTIC_SOLUTION_TRACING 0
+#endif
+
+namespace duneuro {
+
+  template<bool enabled>
+  class BasicTraceRecorder;
+
+  // recorder which does nothing
+  template<>
+  class BasicTraceRecorder<false>
+  {
+  public:
+    static BasicTraceRecorder& instance()
+    {
+      static BasicTraceRecorder recorder;
+      return recorder;
+    }
+
+    static constexpr bool available() { return false; }
+    bool active() const { return false; }
+
+    void start() { throwUnavailable(); }
+    void stop() {}
+    static void setThreadIndex(size_t) {}
+    void write(const std::string&) const { throwUnavailable(); }
+
+  private:
+    static void throwUnavailable()
+    {
+      throw std::runtime_error("duneuro-analytic-solution was built without DUNEURO_ANALYTIC_SOLUTION_TRACING");
+    }
+  };
+
+  // process wide recorder of spans. Every thread appends to its own track, which is locked only by the thread itself and
+  // by start() and write(), so that recording does not contend. The workers of parallelForBlocks announce their thread index,
+  // such that worker i records to track i in every job and the tracks of consecutive jobs can be compared. A track is released
+  // when its thread exits and reused by later threads, so that the number of tracks is bounded by the number of threads
+  // running at the same time. start() and write() may be called while jobs are running, spans which began before the last
+  // start() are dropped.
+  template<>
+  class BasicTraceRecorder<true>
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+      const char* name;
+      const char* category;
+      uint64_t start;    // in nanoseconds since start()
+      uint64_t duration; // in nanoseconds
+    };
+
+    static BasicTraceRecorder& instance()
+    {
+      static BasicTraceRecorder recorder;
+      return recorder;
+    }
+
+    static constexpr bool available() { return true; }
+
+    bool active() const
+    {
+      return active_.load(std::memory_order_relaxed);
+    }
+
+    // discard all recorded events and start recording. All tracks are locked while the origin is moved, so that no track
+    // keeps an event relative to the previous origin.
+    void start()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::vector<std::unique_lock<std::mutex>> trackLocks;
+      for(auto& track : tracks_) {
+        trackLocks.emplace_back(track->mutex);
+      }
+      origin_ = Clock::now().time_since_epoch().count();
+      for(auto& track : tracks_) {
+        track->events.clear();
+      }
+      active_ = true;
+    }
+
+    void stop()
+    {
+      active_ = false;
+    }
+
+    // announce the index of the calling thread in a parallel job, which is used as its track if that is free. Has to be
+    // called before the thread records its first span.
+    static void setThreadIndex(size_t threadIndex)
+    {
+      threadTrack().preferredIndex = threadIndex;
+    }
+
+    void record(const char* name, const char* category, Clock::time_point start, Clock::time_point end)
+    {
+      Track& track = threadTrack().get();
+      std::lock_guard<std::mutex> lock(track.mutex);
+      Clock::time_point origin(Clock::duration(origin_.load(std::memory_order_relaxed)));
+      if(start < origin) {
+        return;
+      }
+      track.events.push_back({name, category, nanoseconds(start - origin), nanoseconds(end - start)});
+    }
+
+    // write the recorded events in the Chrome trace event format. Every track that recorded events becomes one thread.
+    void write(const std::string& filename) const
+    {
+      std::ofstream output(filename);
+      if(!output) {
+        throw std::runtime_error("could not open trace file " + filename);
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      output << std::fixed << std::setprecision(3);
+      output << "{\"traceEvents\":[";
+      bool first = true;
+      for(size_t thread = 0; thread < tracks_.size(); ++thread) {
+        std::lock_guard<std::mutex> trackLock(tracks_[thread]->mutex);
+        const auto& events = tracks_[thread]->events;
+        if(events.empty()) {
+          continue;
+        }
+        output << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread
+               << ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+        first = false;
+        for(const auto& event : events) {
+          // timestamps are given in microseconds
+          output << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+                 << ",\"ts\":" << event.start * 1e-3 << ",\"dur\":" << event.duration * 1e-3 << "}";
+        }
+      }
+      output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+  private:
+    struct Track {
+      mutable std::mutex mutex;
+      std::vector<Event> events;
+      bool inUse = false;
+    };
+
+    // track of the calling thread, acquired on first use and released when the thread exits
+    class ThreadTrack
+    {
+    public:
+      ~ThreadTrack()
+      {
+        if(track_) {
+          BasicTraceRecorder::instance().release(*track_);
+        }
+      }
+
+      Track& get()
+      {
+        if(!track_) {
+          track_ = &BasicTraceRecorder::instance().acquire(preferredIndex);
+        }
+        return *track_;
+      }
+
+      size_t preferredIndex = 0;
+
+    private:
+      Track* track_ = nullptr;
+    };
+
+    BasicTraceRecorder()
+      : active_(false)
+      , origin_(Clock::now().time_since_epoch().count())
+    {
+    }
+
+    static uint64_t nanoseconds(Clock::duration duration)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    static ThreadTrack& threadTrack()
+    {
+      thread_local ThreadTrack track;
+      return track;
+    }
+
+    // the preferred track if it is free, otherwise the first free track or a new one. The tracks are owned by the recorder,
+    // so that the events of threads which have already finished can still be written.
+    Track& acquire(size_t preferredIndex)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      while(tracks_.size() <= preferredIndex) {
+        tracks_.push_back(std::make_unique<Track>());
+      }
+      Track* track = tracks_[preferredIndex].get();
+      for(size_t i = 0; track->inUse; ++i) {
+        if(i == tracks_.size()) {
+          tracks_.push_back(std::make_unique<Track>());
+        }
+        track = tracks_[i].get();
+      }
+      track->inUse = true;
+      return *track;
+    }
+
+    void release(Track& track)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      track.inUse = false;
+    }
+
+    std::atomic<bool> active_;
+    // time point of start() as count of Clock::duration since the epoch of Clock, atomic since spans read it concurrently
+    std::atomic<Clock::rep> origin_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Track>> tracks_;
+  };
+
+  using TraceRecorder = BasicTraceRecorder<DUNEURO_ANALYTIC_SOLUTION_TRACING != 0>;
+
+  template<bool enabled>
+  class BasicTraceSpan;
+
+  template<>
+  class BasicTraceSpan<false>
+  {
+  public:
+    BasicTraceSpan(const char*, const char*) {}
+    // the user provided destructor keeps compilers from warning about unused spans
+    ~BasicTraceSpan() {}
+  };
+
+  // records the lifetime of the object as a span of the calling thread, if the recorder is active
+  template<>
+  class BasicTraceSpan<true>
+  {
+  public:
+    using Recorder = BasicTraceRecorder<true>;
+
+    BasicTraceSpan(const char* name, const char* category)
+      : name_(name)
+      , category_(category)
+      , active_(Recorder::instance().active())
+    {
+      if(active_) {
+        start_ = Recorder::Clock::now();
+      }
+    }
+
+    BasicTraceSpan(const BasicTraceSpan&) = delete;
+    BasicTraceSpan& operator=(const BasicTraceSpan&) = delete;
+
+    ~BasicTraceSpan()
+    {
+      if(active_) {
+        Recorder::instance().record(name_, category_, start_, Recorder::Clock::now());
+      }
+    }
+
+  private:
+    const char* name_;
+    const char* category_;
+    bool active_;
+    Recorder::Clock::time_point start_;
+  };
+
+  using TraceSpan = BasicTraceSpan<DUNEURO_ANALYTIC_SOLUTION_TRACING != 0>;
+
+} // end namespace duneuro
+#endif // DUNEURO_ANALYTIC_SOLUTION_TRACING_HH
@@ -0,0 +1,155 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+
+////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+// Benchmark for the analytic MEG forward solution without the python bindings.
+// Runs the same workload as benchmark_bindings.py through the per-point methods, the
+// batched methods and the lead field computation, so that the numbers of both can be
+// compared to find the overhead of the bindings.
+//
+// usage: benchmark-analytic-solution [#dipoles] [#coils] [#threads] [#repetitions]
+////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/common/fvector.hh>
+#include <duneuro/common/dipole.hh>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Scalar = double;
+enum {dim = 3};
+using CoordinateType = Dune::FieldVector<Scalar, dim>;
+using Dipole = duneuro::Dipole<Scalar, dim>;
+
+// sphere geometry of the benchmark, in mm
+const Scalar sourceRadius = 78.0;
+const Scalar coilRadius = 110.0;
+
+// draw a point uniformly distributed on the sphere of the given radius
+CoordinateType randomPointOnSphere(std::mt19937& generator, Scalar radius)
+{
+  std::normal_distribution<Scalar> normal;
+  CoordinateType point;
+  for(size_t i = 0; i < dim; ++i) {
+    point[i] = normal(generator);
+  }
+  point *= radius / point.two_norm();
+  return point;
+}
+
+// run func repetitions times and return the mean time of one run in seconds
+template<class Function>
+double measure(size_t repetitions, Function&& func)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < repetitions; ++i) {
+    func();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repetitions;
+}
+
+void report(const std::string& name, double seconds, size_t numberOfEvaluations)
+{
+  std::cout << std::left << std::setw(32) << name
+            << std::right << std::setw(14) << std::scientific << std::setprecision(3) << seconds << " s"
+            << std::setw(14) << seconds / numberOfEvaluations * 1e9 << " ns/evaluation" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  auto usage = [&]() {
+    std::cerr << "usage: " << argv[0] << " [#dipoles] [#coils] [#threads] [#repetitions]" << std::endl;
+    return 1;
+  };
+  size_t numberOfDipoles, numberOfCoils, numberOfThreads, repetitions;
+  try {
+    numberOfDipoles = argc > 1 ? std::stoul(argv[1]) : 1000;
+    numberOfCoils = argc > 2 ? std::stoul(argv[2]) : 300;
+    numberOfThreads = argc > 3 ? std::stoul(argv[3]) : 0;
+    repetitions = argc > 4 ? std::stoul(argv[4]) : 5;
+  }
+  catch(const std::invalid_argument&) {
+    return usage();
+  }
+  catch(const std::out_of_range&) {
+    return usage();
+  }
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<Scalar> eccentricity(0.0, 0.99);
+  std::vector<CoordinateType> dipolePositions(numberOfDipoles);
+  std::vector<CoordinateType> dipoleMoments(numberOfDipoles);
+  for(size_t i = 0; i < numberOfDipoles; ++i) {
+    dipolePositions[i] = randomPointOnSphere(generator, eccentricity(generator) * sourceRadius);
+    dipoleMoments[i] = randomPointOnSphere(generator, 1.0);
+  }
+  std::vector<CoordinateType> coilPositions(numberOfCoils);
+  std::vector<CoordinateType> coilDirections(numberOfCoils);
+  for(size_t i = 0; i < numberOfCoils; ++i) {
+    coilPositions[i] = randomPointOnSphere(generator, coilRadius);
+    coilDirections[i] = coilPositions[i] / coilRadius;
+  }
+
+  duneuro::AnalyticSolutionMEG<Scalar> solver(CoordinateType(0.0));
+  size_t numberOfEvaluations = numberOfDipoles * numberOfCoils;
+  std::cout << numberOfDipoles << " dipoles, " << numberOfCoils << " coils, "
+            << (numberOfThreads == 0 ? duneuro::defaultNumberOfThreads() : numberOfThreads) << " threads, "
+            << repetitions << " repetitions" << std::endl;
+
+  // accumulate the results, so that the compiler cannot drop the computations
+  Scalar checksum = 0.0;
+
+  report("per point, vector field", measure(repetitions, [&]() {
+      for(size_t i = 0; i < numberOfDipoles; ++i) {
+        solver.bind(Dipole(dipolePositions[i], dipoleMoments[i]));
+        for(size_t j = 0; j < numberOfCoils; ++j) {
+          checksum += solver.totalField(coilPositions[j])[0];
+        }
+      }
+    }), numberOfEvaluations);
+
+  report("per point, projected field", measure(repetitions, [&]() {
+      for(size_t i = 0; i < numberOfDipoles; ++i) {
+        solver.bind(Dipole(dipolePositions[i], dipoleMoments[i]));
+        for(size_t j = 0; j < numberOfCoils; ++j) {
+          checksum += solver.totalField(coilPositions[j], coilDirections[j]);
+        }
+      }
+    }), numberOfEvaluations);
+
+  report("batched, vector field", measure(repetitions, [&]() {
+      for(size_t i = 0; i < numberOfDipoles; ++i) {
+        solver.bind(Dipole(dipolePositions[i], dipoleMoments[i]));
+        checksum += solver.totalField(coilPositions)[0][0];
+      }
+    }), numberOfEvaluations);
+
+  report("batched, projected field", measure(repetitions, [&]() {
+      for(size_t i = 0; i < numberOfDipoles; ++i) {
+        solver.bind(Dipole(dipolePositions[i], dipoleMoments[i]));
+        checksum += solver.totalField(coilPositions, coilDirections)[0];
+      }
+    }), numberOfEvaluations);
+
+  // one lead field evaluation yields the fields of three unit dipoles
+  report("lead field (3 columns)", measure(repetitions, [&]() {
+      checksum += solver.leadField(dipolePositions, coilPositions, coilDirections, numberOfThreads)[0];
+    }), numberOfEvaluations);
+
+  std::cout << "checksum: " << checksum << std::endl;
+  return 0;
+}
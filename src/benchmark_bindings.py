@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Benchmark for the overhead of the python bindings of the analytic MEG forward solution.
+
+Runs the same workload as the C++ harness benchmark-analytic-solution through the bindings
+registered in register_analytic_solution_meg, once per point and once through the batched
+numpy methods and the lead field. Only differences of runs that differ in a single aspect are
+reported as overhead:
+  - the conversion of python lists into FieldVectors, i.e. the same method called with lists
+    and with FieldVectors,
+  - the cost of a python call per point, i.e. the same field computed per point and batched.
+The per point cost includes the dispatch of the call and the allocation of the result, which
+cannot be separated through the bindings.
+
+Comparing the ns/evaluation columns with the output of benchmark-analytic-solution shows
+how much of the time is spent in the bindings. Use --json to store the results and
+--baseline to compare against stored results, e.g. to catch regressions in the bindings.
+
+usage: python3 benchmark_bindings.py [--dipoles N] [--coils N] [--threads N]
+                                     [--repetitions N] [--json FILE]
+                                     [--baseline FILE] [--tolerance T]
+"""
+
+import argparse
+import json
+import sys
+import time
+
+import numpy as np
+import duneuropy as dp
+import duneuroAnalyticSolutionPy as das
+
+# sphere geometry of the benchmark, in mm, identical to benchmark-analytic-solution
+SOURCE_RADIUS = 78.0
+COIL_RADIUS = 110.0
+
+
+def random_points_on_sphere(generator, radii):
+    points = generator.normal(size=(len(radii), 3))
+    return points * (radii / np.linalg.norm(points, axis=1))[:, np.newaxis]
+
+
+def measure(repetitions, func):
+    """run func repetitions times and return the mean time of one run in seconds"""
+    start = time.perf_counter()
+    for _ in range(repetitions):
+        func()
+    return (time.perf_counter() - start) / repetitions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--dipoles', type=int, default=1000)
+    parser.add_argument('--coils', type=int, default=300)
+    parser.add_argument('--threads', type=int, default=0)
+    parser.add_argument('--repetitions', type=int, default=5)
+    parser.add_argument('--json', help='write the results to this file')
+    parser.add_argument('--baseline', help='compare the results to a file written by --json')
+    parser.add_argument('--tolerance', type=float, default=0.25,
+                        help='relative slowdown compared to the baseline that is reported as a regression')
+    args = parser.parse_args()
+
+    generator = np.random.default_rng(42)
+    dipole_positions = random_points_on_sphere(generator, generator.uniform(0.0, 0.99, args.dipoles) * SOURCE_RADIUS)
+    dipole_moments = random_points_on_sphere(generator, np.ones(args.dipoles))
+    coil_positions = random_points_on_sphere(generator, np.full(args.coils, COIL_RADIUS))
+    coil_directions = coil_positions / COIL_RADIUS
+
+    dipoles = [dp.Dipole3d(dp.FieldVector3D(list(p)), dp.FieldVector3D(list(m)))
+               for p, m in zip(dipole_positions, dipole_moments)]
+    coil_lists = [list(p) for p in coil_positions]
+    direction_lists = [list(d) for d in coil_directions]
+    coil_vectors = [dp.FieldVector3D(p) for p in coil_lists]
+    direction_vectors = [dp.FieldVector3D(d) for d in direction_lists]
+
+    solver = das.AnalyticSolutionMEG(dp.FieldVector3D([0.0, 0.0, 0.0]))
+    evaluations = args.dipoles * args.coils
+
+    def per_point_lists():
+        for dipole in dipoles:
+            solver.bind(dipole)
+            for coil in coil_lists:
+                solver.totalField(coil)
+
+    def per_point_vectors():
+        for dipole in dipoles:
+            solver.bind(dipole)
+            for coil in coil_vectors:
+                solver.totalField(coil)
+
+    def per_point_projected_lists():
+        for dipole in dipoles:
+            solver.bind(dipole)
+            for coil, direction in zip(coil_lists, direction_lists):
+                solver.totalField(coil, direction)
+
+    def per_point_projected_vectors():
+        for dipole in dipoles:
+            solver.bind(dipole)
+            for coil, direction in zip(coil_vectors, direction_vectors):
+                solver.totalField(coil, direction)
+
+    def batched_vector():
+        for dipole in dipoles:
+            solver.bind(dipole)
+            solver.totalFieldBatch(coil_positions)
+
+    def batched_projected():
+        for dipole in dipoles:
+            solver.bind(dipole)
+            solver.totalFieldBatch(coil_positions, coil_directions)
+
+    def lead_field():
+        solver.leadField(dipole_positions, coil_positions, coil_directions, args.threads)
+
+    benchmarks = [
+        # FieldVector returned, arguments converted from lists
+        ('per point, vector field, lists', per_point_lists),
+        # FieldVector returned, no conversion of the arguments
+        ('per point, vector field, FieldVectors', per_point_vectors),
+        # scalar returned, arguments converted from lists
+        ('per point, projected field, lists', per_point_projected_lists),
+        # scalar returned, no conversion of the arguments
+        ('per point, projected field, FieldVectors', per_point_projected_vectors),
+        ('batched, vector field', batched_vector),
+        ('batched, projected field', batched_projected),
+        ('lead field (3 columns)', lead_field),
+    ]
+
+    print('{} dipoles, {} coils, {} threads, {} repetitions'.format(args.dipoles, args.coils, args.threads, args.repetitions))
+    results = {}
+    for name, func in benchmarks:
+        seconds = measure(args.repetitions, func)
+        results[name] = seconds / evaluations * 1e9
+        print('{:<44}{:>12.3e} s{:>12.1f} ns/evaluation'.format(name, seconds, results[name]))
+
+    vectors = results['per point, vector field, FieldVectors']
+    projected = results['per point, projected field, FieldVectors']
+    print()
+    print('estimated overhead per call:')
+    print('  FieldVector conversion, 1 argument  : {:8.1f} ns'.format(results['per point, vector field, lists'] - vectors))
+    print('  FieldVector conversion, 2 arguments : {:8.1f} ns'.format(results['per point, projected field, lists'] - projected))
+    print('  per point vs batched, vector field  : {:8.1f} ns'.format(vectors - results['batched, vector field']))
+    print('  per point vs batched, projected     : {:8.1f} ns'.format(projected - results['batched, projected field']))
+
+    if args.json:
+        with open(args.json, 'w') as output:
+            json.dump({'dipoles': args.dipoles, 'coils': args.coils, 'threads': args.threads,
+                       'ns_per_evaluation': results}, output, indent=2)
+
+    if args.baseline:
+        with open(args.baseline) as baseline_file:
+            baseline = json.load(baseline_file)['ns_per_evaluation']
+        regressions = [name for name in results
+                       if name in baseline and results[name] > (1.0 + args.tolerance) * baseline[name]]
+        for name in regressions:
+            print('regression: {} took {:.1f} ns/evaluation, baseline {:.1f} ns/evaluation'.format(
+                name, results[name], baseline[name]))
+        if regressions:
+            return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,276 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+
+////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+// Compare MEG solutions computed with duneuro (e.g. FEM) in a multilayer sphere model
+// to the analytic solution. The analytic fields of all dipoles are computed in
+// parallel, and RDM and lnMAG of the numerical solution are reported per dipole and
+// per eccentricity, together with the timings of both sides. Dipoles with non-finite
+// measures, e.g. radial dipoles whose analytic field vanishes, are counted per
+// eccentricity but only their raw values are written to the per dipole output.
+//
+// usage: compare-fem-meg config.ini
+//
+// The configuration file is read with Dune::ParameterTreeParser and contains
+//
+//   [sphere]
+//   center = 127 127 127          # sphere center
+//   radius = 92                   # outer radius of the conductor, used for the eccentricity
+//   scaling_factor = 1.0          # scaling factor of the analytic solution
+//   [dipoles]
+//   filename = dipoles.txt        # one dipole "x y z mx my mz" per line
+//   [coils]
+//   positions = coils.txt         # one coil "x y z" per line
+//   projections = projections.txt # one direction "x y z" per line
+//   [fem]
+//   solution = fem_solution.txt   # one line per dipole, containing one value per coil
+//   timings = fem_timings.txt     # optional, one line per dipole, time of the numerical solution in s
+//   field = total                 # total, primary or secondary
+//   [output]
+//   filename = errors.txt         # optional, per dipole errors
+//   threads = 0                   # 0 means one thread per hardware thread
+//   eccentricity_bins = 10
+////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/error-measures.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/common/parametertreeparser.hh>
+#include <duneuro/common/dipole.hh>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Scalar = double;
+enum {dim = 3};
+using CoordinateType = Dune::FieldVector<Scalar, dim>;
+using Dipole = duneuro::Dipole<Scalar, dim>;
+using AnalyticSolution = duneuro::AnalyticSolutionMEG<Scalar>;
+
+// read a whitespace separated matrix, one row per non-empty line
+std::vector<std::vector<Scalar>> readMatrix(const std::string& filename)
+{
+  std::ifstream input(filename);
+  if(!input) {
+    DUNE_THROW(Dune::IOError, "could not open " << filename);
+  }
+  std::vector<std::vector<Scalar>> rows;
+  std::string line;
+  while(std::getline(input, line)) {
+    std::istringstream lineStream(line);
+    std::vector<Scalar> row;
+    Scalar value;
+    while(lineStream >> value) {
+      row.push_back(value);
+    }
+    if(!row.empty()) {
+      rows.push_back(row);
+    }
+  }
+  return rows;
+}
+
+std::vector<CoordinateType> readCoordinates(const std::string& filename)
+{
+  auto rows = readMatrix(filename);
+  std::vector<CoordinateType> coordinates(rows.size());
+  for(size_t i = 0; i < rows.size(); ++i) {
+    if(rows[i].size() != dim) {
+      DUNE_THROW(Dune::IOError, filename << ", line " << i + 1 << ": expected 3 values");
+    }
+    std::copy(rows[i].begin(), rows[i].end(), coordinates[i].begin());
+  }
+  return coordinates;
+}
+
+std::vector<Dipole> readDipoles(const std::string& filename)
+{
+  auto rows = readMatrix(filename);
+  std::vector<Dipole> dipoles;
+  dipoles.reserve(rows.size());
+  for(size_t i = 0; i < rows.size(); ++i) {
+    if(rows[i].size() != 2 * dim) {
+      DUNE_THROW(Dune::IOError, filename << ", line " << i + 1 << ": expected 6 values");
+    }
+    CoordinateType position, moment;
+    std::copy(rows[i].begin(), rows[i].begin() + dim, position.begin());
+    std::copy(rows[i].begin() + dim, rows[i].end(), moment.begin());
+    dipoles.emplace_back(position, moment);
+  }
+  return dipoles;
+}
+
+// accumulated errors of all dipoles in one eccentricity bin. Dipoles whose measures are not finite, e.g. since the analytic
+// field vanishes for a radial dipole or a dipole at the center, are only counted, such that mean and maximum are taken over
+// the same dipoles.
+struct ErrorSummary {
+  size_t count = 0;
+  size_t nonFiniteCount = 0;
+  Scalar rdmSum = 0.0;
+  Scalar rdmMax = 0.0;
+  Scalar lnMagSum = 0.0;
+  Scalar lnMagAbsMax = 0.0;
+
+  void add(Scalar rdm, Scalar lnMag)
+  {
+    if(!std::isfinite(rdm) || !std::isfinite(lnMag)) {
+      ++nonFiniteCount;
+      return;
+    }
+    ++count;
+    rdmSum += rdm;
+    rdmMax = std::max(rdmMax, rdm);
+    lnMagSum += lnMag;
+    lnMagAbsMax = std::max(lnMagAbsMax, std::abs(lnMag));
+  }
+};
+
+int main(int argc, char** argv)
+{
+  try {
+    if(argc != 2) {
+      std::cerr << "usage: " << argv[0] << " config.ini" << std::endl;
+      return 1;
+    }
+    Dune::ParameterTree config;
+    Dune::ParameterTreeParser::readINITree(argv[1], config);
+
+    CoordinateType sphereCenter = config.get<CoordinateType>("sphere.center");
+    Scalar sphereRadius = config.get<Scalar>("sphere.radius");
+    AnalyticSolution prototype(sphereCenter, config.get<Scalar>("sphere.scaling_factor", 1.0));
+
+    auto dipoles = readDipoles(config.get<std::string>("dipoles.filename"));
+    auto coilPositions = readCoordinates(config.get<std::string>("coils.positions"));
+    auto coilProjections = readCoordinates(config.get<std::string>("coils.projections"));
+    auto femSolution = readMatrix(config.get<std::string>("fem.solution"));
+    if(femSolution.size() != dipoles.size()) {
+      DUNE_THROW(Dune::Exception, "numerical solution contains " << femSolution.size() << " rows, but there are " << dipoles.size() << " dipoles");
+    }
+    for(size_t i = 0; i < femSolution.size(); ++i) {
+      if(femSolution[i].size() != coilPositions.size()) {
+        DUNE_THROW(Dune::Exception, "numerical solution of dipole " << i << " contains " << femSolution[i].size() << " values, but there are " << coilPositions.size() << " coils");
+      }
+    }
+    std::vector<Scalar> femTimings(dipoles.size(), std::numeric_limits<Scalar>::quiet_NaN());
+    if(config.hasKey("fem.timings")) {
+      auto rows = readMatrix(config.get<std::string>("fem.timings"));
+      if(rows.size() != dipoles.size()) {
+        DUNE_THROW(Dune::Exception, "number of timings does not match the number of dipoles");
+      }
+      for(size_t i = 0; i < rows.size(); ++i) {
+        femTimings[i] = rows[i][0];
+      }
+    }
+
+    std::string field = config.get<std::string>("fem.field", "total");
+    if(field != "total" && field != "primary" && field != "secondary") {
+      DUNE_THROW(Dune::Exception, "unknown field type " << field << ", expected total, primary or secondary");
+    }
+    size_t numberOfThreads = duneuro::resolveNumberOfThreads(config.get<size_t>("output.threads", 0));
+
+    // compute analytic solutions and error measures of all dipoles in parallel, every thread binds its own solver
+    std::vector<AnalyticSolution> solvers(numberOfThreads, prototype);
+    std::vector<Scalar> rdm(dipoles.size());
+    std::vector<Scalar> lnMag(dipoles.size());
+    std::vector<Scalar> analyticTimings(dipoles.size());
+    auto start = std::chrono::steady_clock::now();
+    duneuro::parallelForBlocks(dipoles.size(), 1, numberOfThreads, [&](size_t blockBegin, size_t blockEnd, size_t threadIndex) {
+      auto& solver = solvers[threadIndex];
+      for(size_t i = blockBegin; i < blockEnd; ++i) {
+        auto dipoleStart = std::chrono::steady_clock::now();
+        solver.bind(dipoles[i]);
+        std::vector<Scalar> analytic;
+        if(field == "total") {
+          analytic = solver.totalField(coilPositions, coilProjections);
+        }
+        else if(field == "primary") {
+          analytic = solver.primaryField(coilPositions, coilProjections);
+        }
+        else {
+          analytic = solver.secondaryField(coilPositions, coilProjections);
+        }
+        analyticTimings[i] = std::chrono::duration<Scalar>(std::chrono::steady_clock::now() - dipoleStart).count();
+        auto measures = duneuro::rowErrorMeasures(analytic.data(), femSolution[i].data(), analytic.size());
+        rdm[i] = measures.rdm;
+        lnMag[i] = measures.lnMag;
+      }
+    });
+    Scalar analyticWallTime = std::chrono::duration<Scalar>(std::chrono::steady_clock::now() - start).count();
+
+    // summarize per eccentricity
+    size_t numberOfBins = std::max<size_t>(config.get<size_t>("output.eccentricity_bins", 10), 1);
+    std::vector<ErrorSummary> bins(numberOfBins);
+    std::vector<Scalar> eccentricities(dipoles.size());
+    for(size_t i = 0; i < dipoles.size(); ++i) {
+      eccentricities[i] = (dipoles[i].position() - sphereCenter).two_norm() / sphereRadius;
+      size_t bin = std::min(static_cast<size_t>(eccentricities[i] * numberOfBins), numberOfBins - 1);
+      bins[bin].add(rdm[i], lnMag[i]);
+    }
+
+    if(config.hasKey("output.filename")) {
+      std::ofstream output(config.get<std::string>("output.filename"));
+      output << "# dipole eccentricity rdm lnmag analytic_time fem_time" << std::endl;
+      output << std::setprecision(10);
+      for(size_t i = 0; i < dipoles.size(); ++i) {
+        output << i << " " << eccentricities[i] << " " << rdm[i] << " " << lnMag[i] << " " << analyticTimings[i] << " " << femTimings[i] << std::endl;
+      }
+    }
+
+    std::cout << dipoles.size() << " dipoles, " << coilPositions.size() << " coils, " << field << " field, " << numberOfThreads << " threads" << std::endl;
+    std::cout << std::setw(22) << "eccentricity" << std::setw(8) << "count" << std::setw(14) << "non-finite" << std::setw(14) << "mean RDM"
+              << std::setw(14) << "max RDM" << std::setw(14) << "mean lnMAG" << std::setw(14) << "max |lnMAG|" << std::endl;
+    std::cout << std::scientific << std::setprecision(3);
+    for(size_t bin = 0; bin < numberOfBins; ++bin) {
+      if(bins[bin].count == 0 && bins[bin].nonFiniteCount == 0) {
+        continue;
+      }
+      std::ostringstream range;
+      range << std::fixed << std::setprecision(3) << static_cast<Scalar>(bin) / numberOfBins << " - " << static_cast<Scalar>(bin + 1) / numberOfBins;
+      std::cout << std::setw(22) << range.str() << std::setw(8) << bins[bin].count << std::setw(14) << bins[bin].nonFiniteCount;
+      if(bins[bin].count == 0) {
+        std::cout << std::setw(14) << "-" << std::setw(14) << "-" << std::setw(14) << "-" << std::setw(14) << "-" << std::endl;
+        continue;
+      }
+      std::cout << std::setw(14) << bins[bin].rdmSum / bins[bin].count << std::setw(14) << bins[bin].rdmMax
+                << std::setw(14) << bins[bin].lnMagSum / bins[bin].count << std::setw(14) << bins[bin].lnMagAbsMax << std::endl;
+    }
+
+    Scalar analyticTime = 0.0;
+    for(auto time : analyticTimings) {
+      analyticTime += time;
+    }
+    std::cout << "analytic solution: " << analyticWallTime << " s wall time, " << analyticTime / dipoles.size() << " s per dipole" << std::endl;
+    if(config.hasKey("fem.timings")) {
+      Scalar femTime = 0.0;
+      for(auto time : femTimings) {
+        femTime += time;
+      }
+      std::cout << "numerical solution: " << femTime << " s in total, " << femTime / dipoles.size() << " s per dipole" << std::endl;
+    }
+    return 0;
+  }
+  catch(Dune::Exception& e) {
+    std::cerr << "Dune reported error: " << e << std::endl;
+    return 1;
+  }
+  catch(std::exception& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  }
+}
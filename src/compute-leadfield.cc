@@ -0,0 +1,220 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+
+////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+// Compute the MEG lead field of a source space in a sphere model without the python
+// bindings, e.g. in batch jobs on a cluster. The dipole positions are processed in
+// chunks with the multi-threaded lead field builders, and every chunk is copied into
+// a memory mapped lead field file (see leadfield-file.hh), so that memory stays bounded
+// by the size of one chunk and the result can be mapped by the consumer.
+//
+// usage: compute-leadfield [config.ini] [-key value ...]
+//
+// The parameters are read with Dune::ParameterTreeParser from the optional configuration
+// file, and options on the command line, e.g. -output.threads 8, override them:
+//
+//   [sphere]
+//   center = 127 127 127          # sphere center
+//   scaling_factor = 1.0          # scaling factor of the analytic solution
+//   [dipoles]
+//   positions = dipoles.txt       # dipole positions
+//   [coils]
+//   positions = coils.txt         # coil positions
+//   directions = directions.txt   # coil directions
+//   [input]
+//   format = text                 # text: one point "x y z" per line,
+//                                 # binary: raw row major float64 array of shape (N, 3),
+//                                 # points: point set files (see point-set-file.hh), where
+//                                 # the coil file contains the directions and
+//                                 # coils.directions is not used
+//   [output]
+//   filename = leadfield.lf       # lead field file of size #coils x (3 * #dipoles)
+//   field = total                 # total, primary or secondary
+//   precision = double            # double or float
+//   threads = 0                   # 0 means one thread per hardware thread
+//   chunk_size = 4096             # number of dipole positions per chunk
+////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>
+#include <dune/duneuro-analytic-solution/leadfield-file.hh>
+#include <dune/duneuro-analytic-solution/point-set-file.hh>
+#include <dune/duneuro-analytic-solution/parallel.hh>
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/common/parametertreeparser.hh>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+enum {dim = 3};
+
+// read one point per line from a text file, or a row major array of shape (N, 3) of float64 from a binary file
+template<class FieldType>
+std::vector<Dune::FieldVector<FieldType, dim>> readPoints(const std::string& filename, const std::string& format)
+{
+  std::ifstream input(filename, format == "binary" ? std::ios::binary : std::ios::in);
+  if(!input) {
+    DUNE_THROW(Dune::IOError, "could not open " << filename);
+  }
+  std::vector<Dune::FieldVector<FieldType, dim>> points;
+  if(format == "binary") {
+    double values[dim];
+    while(input.read(reinterpret_cast<char*>(values), sizeof(values))) {
+      points.push_back({static_cast<FieldType>(values[0]), static_cast<FieldType>(values[1]), static_cast<FieldType>(values[2])});
+    }
+    if(input.gcount() != 0) {
+      DUNE_THROW(Dune::IOError, filename << ": size is not a multiple of 3 float64 values");
+    }
+    return points;
+  }
+  if(format != "text") {
+    DUNE_THROW(Dune::Exception, "unknown input format " << format << ", expected text, binary or points");
+  }
+  std::string line;
+  for(size_t lineNumber = 1; std::getline(input, line); ++lineNumber) {
+    std::istringstream lineStream(line);
+    std::vector<FieldType> row;
+    FieldType value;
+    while(lineStream >> value) {
+      row.push_back(value);
+    }
+    if(row.empty()) {
+      continue;
+    }
+    if(row.size() != dim) {
+      DUNE_THROW(Dune::IOError, filename << ", line " << lineNumber << ": expected 3 values");
+    }
+    points.push_back({row[0], row[1], row[2]});
+  }
+  return points;
+}
+
+template<class FieldType>
+void computeLeadField(const Dune::ParameterTree& config)
+{
+  using Coordinate = Dune::FieldVector<FieldType, dim>;
+
+  // the dipole positions of point set files stay mapped and are passed to the lead field builder chunk by chunk
+  std::string format = config.get<std::string>("input.format", "text");
+  std::unique_ptr<duneuro::PointSetView<FieldType>> mappedDipoles;
+  std::vector<Coordinate> dipolePositions;
+  std::vector<Coordinate> coilPositions;
+  std::vector<Coordinate> coilDirections;
+  if(format == "points") {
+    mappedDipoles = std::make_unique<duneuro::PointSetView<FieldType>>(duneuro::mapPointSetFile<FieldType>(config.get<std::string>("dipoles.positions")));
+    auto coils = duneuro::mapPointSetFile<FieldType>(config.get<std::string>("coils.positions"));
+    coilPositions = coils.positions();
+    coilDirections = coils.directions();
+  }
+  else {
+    dipolePositions = readPoints<FieldType>(config.get<std::string>("dipoles.positions"), format);
+    coilPositions = readPoints<FieldType>(config.get<std::string>("coils.positions"), format);
+    coilDirections = readPoints<FieldType>(config.get<std::string>("coils.directions"), format);
+  }
+  const size_t numberOfDipoles = mappedDipoles ? mappedDipoles->size() : dipolePositions.size();
+
+  std::string field = config.get<std::string>("output.field", "total");
+  duneuro::LeadFieldFileField fileField;
+  if(field == "total") {
+    fileField = duneuro::LeadFieldFileField::total;
+  }
+  else if(field == "primary") {
+    fileField = duneuro::LeadFieldFileField::primary;
+  }
+  else if(field == "secondary") {
+    fileField = duneuro::LeadFieldFileField::secondary;
+  }
+  else {
+    DUNE_THROW(Dune::Exception, "unknown field type " << field << ", expected total, primary or secondary");
+  }
+  size_t numberOfThreads = duneuro::resolveNumberOfThreads(config.get<size_t>("output.threads", 0));
+  size_t chunkSize = std::max<size_t>(config.get<size_t>("output.chunk_size", 4096), 1);
+
+  Dune::FieldVector<double, dim> center = config.get<Dune::FieldVector<double, dim>>("sphere.center");
+  duneuro::AnalyticSolutionMEG<FieldType> solver(Coordinate{static_cast<FieldType>(center[0]), static_cast<FieldType>(center[1]), static_cast<FieldType>(center[2])},
+                                                 config.get<FieldType>("sphere.scaling_factor", 1.0));
+
+  const size_t columns = dim * numberOfDipoles;
+  duneuro::LeadFieldFileWriter<FieldType> writer(config.get<std::string>("output.filename"), coilPositions.size(), columns, fileField);
+
+  // the lead field of one chunk of dipole positions, which are either a subset of the mapped point set or copied
+  auto chunkLeadField = [&](const auto& chunk) {
+    if(fileField == duneuro::LeadFieldFileField::total) {
+      return solver.leadField(chunk, coilPositions, coilDirections, numberOfThreads);
+    }
+    else if(fileField == duneuro::LeadFieldFileField::primary) {
+      return solver.primaryLeadField(chunk, coilPositions, coilDirections, numberOfThreads);
+    }
+    else {
+      return solver.secondaryLeadField(chunk, coilPositions, coilDirections, numberOfThreads);
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for(size_t chunkBegin = 0; chunkBegin < numberOfDipoles; chunkBegin += chunkSize) {
+    const size_t chunkEnd = std::min(chunkBegin + chunkSize, numberOfDipoles);
+    std::vector<FieldType> leadField;
+    if(mappedDipoles) {
+      leadField = chunkLeadField(mappedDipoles->subset(chunkBegin, chunkEnd));
+    }
+    else {
+      leadField = chunkLeadField(std::vector<Coordinate>(dipolePositions.begin() + chunkBegin, dipolePositions.begin() + chunkEnd));
+    }
+    writer.writeColumns(leadField.data(), dim * (chunkEnd - chunkBegin), dim * chunkBegin);
+  }
+  writer.sync();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << numberOfDipoles << " dipoles, " << coilPositions.size() << " coils, " << field << " field, "
+            << sizeof(FieldType) * 8 << " bit, " << numberOfThreads << " threads: " << seconds << " s" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  try {
+    Dune::ParameterTree config;
+    int firstOption = 1;
+    if(argc > 1 && argv[1][0] != '-') {
+      Dune::ParameterTreeParser::readINITree(argv[1], config);
+      firstOption = 2;
+    }
+    // readOptions skips its first argument like a program name
+    Dune::ParameterTreeParser::readOptions(argc - firstOption + 1, argv + firstOption - 1, config);
+    if(!config.hasKey("dipoles.positions") || !config.hasKey("coils.positions") || !config.hasKey("output.filename")) {
+      std::cerr << "usage: " << argv[0] << " [config.ini] [-key value ...], see the head of compute-leadfield.cc for the keys" << std::endl;
+      return 1;
+    }
+
+    std::string precision = config.get<std::string>("output.precision", "double");
+    if(precision == "double") {
+      computeLeadField<double>(config);
+    }
+    else if(precision == "float") {
+      computeLeadField<float>(config);
+    }
+    else {
+      DUNE_THROW(Dune::Exception, "unknown precision " << precision << ", expected double or float");
+    }
+    return 0;
+  }
+  catch(Dune::Exception& e) {
+    std::cerr << "Dune reported error: " << e << std::endl;
+    return 1;
+  }
+  catch(std::exception& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  }
+}
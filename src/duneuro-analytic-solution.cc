@@ -14,17 +14,281 @@
 
 #include <dune/python/pybind11/pybind11.h>
 #include <dune/python/pybind11/operators.h>                                           // include for easy binding of +=, *=, etc.
-#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>                // include for analytic MEG solution in sphere models
+#include <dune/python/pybind11/numpy.h>                                               // include for the batched methods working on numpy arrays
+#include <dune/duneuro-analytic-solution/duneuro-analytic-solution.hh>                // include for analytic MEG and EEG solutions in sphere models
+#include <dune/duneuro-analytic-solution/channel-transform.hh>                        // include for the channel transforms of the lead field builders
+#include <dune/duneuro-analytic-solution/error-measures.hh>                           // include for RDM, MAG, etc.
+#include <dune/duneuro-analytic-solution/leadfield-cache.hh>                          // include for the persistent lead field cache
+#include <dune/duneuro-analytic-solution/leadfield-file.hh>                           // include for the lead field files of compute-leadfield
+#include <dune/duneuro-analytic-solution/point-set-file.hh>                           // include for the memory mapped source spaces and sensors
+#include <dune/duneuro-analytic-solution/patch-sources.hh>                           // include for the quadrature of patch sources
+#include <dune/duneuro-analytic-solution/leadfield-column-cache.hh>                   // include for the in-memory cache of single positions
+#include <dune/duneuro-analytic-solution/lookup-table.hh>                             // include for the tabulated approximate lead field
+#include <dune/duneuro-analytic-solution/multipole-expansion.hh>                      // include for multipole expansions and the SSS basis
+#include <dune/duneuro-analytic-solution/hierarchical-evaluator.hh>                   // include for the octree evaluation of many dipoles
+#include <dune/duneuro-analytic-solution/berg-approximation.hh>                       // include for the fast approximate EEG solution
+#include <dune/duneuro-analytic-solution/joint-leadfield.hh>                          // include for the combined EEG and MEG lead field
+#include <dune/duneuro-analytic-solution/sphere-fit.hh>                               // include for fitting spheres to head surface points
 #include <dune/common/fvector.hh>
 #include <duneuro/common/dipole.hh>
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <string>
+#include <array>
+#include <complex>
+#include <cstdint>
 
 namespace py = pybind11;
 using Scalar = double;
 enum {dim = 3};
 using CoordinateType = Dune::FieldVector<Scalar, dim>;
 using Dipole = duneuro::Dipole<Scalar, dim>;
+using AnalyticSolution = duneuro::AnalyticSolutionMEG<Scalar>;
+using CoordinateArray = py::array_t<Scalar, py::array::c_style | py::array::forcecast>;
+using IndexArray = py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>;
+using ComplexArray = py::array_t<std::complex<Scalar>, py::array::c_style | py::array::forcecast>;
+using PointSet = duneuro::PointSetView<Scalar>;
+
+///////////////////////////////////////////////////////////
+// Conversion between numpy arrays and the containers used by the batched methods
+///////////////////////////////////////////////////////////
+
+// convert a numpy array of shape (N, 3) into a vector of coordinates
+std::vector<CoordinateType> toCoordinates(const CoordinateArray& array)
+{
+  if(array.ndim() != 2 || array.shape(1) != dim) {
+    throw py::value_error("expected an array of shape (N, 3)");
+  }
+  auto entries = array.unchecked<2>();
+  std::vector<CoordinateType> coordinates(array.shape(0));
+  for(py::ssize_t i = 0; i < array.shape(0); ++i) {
+    for(py::ssize_t j = 0; j < dim; ++j) {
+      coordinates[i][j] = entries(i, j);
+    }
+  }
+  return coordinates;
+}
+
+// convert a numpy array of shape (..., 3), e.g. (T, S, 3), into a vector of coordinates in row major order
+std::vector<CoordinateType> flattenCoordinates(const CoordinateArray& array)
+{
+  if(array.ndim() < 1 || array.shape(array.ndim() - 1) != dim) {
+    throw py::value_error("expected an array of shape (..., 3)");
+  }
+  std::vector<CoordinateType> coordinates(array.size() / dim);
+  const Scalar* entries = array.data();
+  for(size_t i = 0; i < coordinates.size(); ++i) {
+    std::copy_n(entries + dim * i, dim, coordinates[i].begin());
+  }
+  return coordinates;
+}
+
+// convert numpy arrays of shape (N, 3) containing positions and moments into a vector of dipoles
+std::vector<Dipole> toDipoles(const CoordinateArray& positions, const CoordinateArray& moments)
+{
+  auto dipolePositions = toCoordinates(positions);
+  auto dipoleMoments = toCoordinates(moments);
+  if(dipolePositions.size() != dipoleMoments.size()) {
+    throw py::value_error("number of dipole positions and number of dipole moments differ");
+  }
+  std::vector<Dipole> dipoles;
+  dipoles.reserve(dipolePositions.size());
+  for(size_t i = 0; i < dipolePositions.size(); ++i) {
+    dipoles.emplace_back(dipolePositions[i], dipoleMoments[i]);
+  }
+  return dipoles;
+}
+
+// convert numpy arrays of shape (S, 3) containing positions and (S, k, 3) containing the axes of every sensor into a vector of
+// multi-axis sensors with k axes each
+std::vector<duneuro::MultiAxisSensor<Scalar>> toSensors(const CoordinateArray& positions, const CoordinateArray& axes)
+{
+  auto sensorPositions = toCoordinates(positions);
+  if(axes.ndim() != 3 || static_cast<size_t>(axes.shape(0)) != sensorPositions.size() || axes.shape(2) != dim) {
+    throw py::value_error("expected sensor axes of shape (S, k, 3)");
+  }
+  auto entries = axes.unchecked<3>();
+  std::vector<duneuro::MultiAxisSensor<Scalar>> sensors;
+  sensors.reserve(sensorPositions.size());
+  for(size_t i = 0; i < sensorPositions.size(); ++i) {
+    std::vector<CoordinateType> sensorAxes(axes.shape(1));
+    for(py::ssize_t axis = 0; axis < axes.shape(1); ++axis) {
+      for(py::ssize_t j = 0; j < dim; ++j) {
+        sensorAxes[axis][j] = entries(i, axis, j);
+      }
+    }
+    try {
+      sensors.emplace_back(sensorPositions[i], sensorAxes);
+    }
+    catch(const std::invalid_argument& error) {
+      throw py::value_error(error.what());
+    }
+  }
+  return sensors;
+}
+
+// convert a list of numpy arrays of shape (#outputChannels, #inputChannels) into channel transforms, applied in list order
+std::vector<duneuro::ChannelTransform<Scalar>> toChannelTransforms(const py::list& matrices)
+{
+  std::vector<duneuro::ChannelTransform<Scalar>> transforms;
+  for(const auto& item : matrices) {
+    auto matrix = item.cast<py::array_t<Scalar, py::array::c_style | py::array::forcecast>>();
+    if(matrix.ndim() != 2) {
+      throw py::value_error("expected channel transforms of shape (#output channels, #input channels)");
+    }
+    transforms.emplace_back(matrix.shape(0), matrix.shape(1), std::vector<Scalar>(matrix.data(), matrix.data() + matrix.size()));
+  }
+  return transforms;
+}
+
+// convert a one-dimensional numpy array into a vector
+std::vector<Scalar> toVector(const py::array_t<Scalar, py::array::c_style | py::array::forcecast>& array)
+{
+  if(array.ndim() != 1) {
+    throw py::value_error("expected a one-dimensional array");
+  }
+  return std::vector<Scalar>(array.data(), array.data() + array.size());
+}
+
+// convert a one-dimensional numpy array of non-negative integers into a vector of indices
+std::vector<size_t> toIndices(const IndexArray& array)
+{
+  if(array.ndim() != 1) {
+    throw py::value_error("expected a one-dimensional array");
+  }
+  std::vector<size_t> indices(array.size());
+  for(py::ssize_t i = 0; i < array.size(); ++i) {
+    if(array.data()[i] < 0) {
+      throw py::value_error("expected non-negative indices");
+    }
+    indices[i] = static_cast<size_t>(array.data()[i]);
+  }
+  return indices;
+}
+
+// convert a numpy array of shape (T, 3) of vertex indices into a vector of triangles
+std::vector<std::array<size_t, 3>> toTriangles(const IndexArray& array)
+{
+  if(array.ndim() != 2 || array.shape(1) != 3) {
+    throw py::value_error("expected an array of shape (T, 3)");
+  }
+  auto entries = array.unchecked<2>();
+  std::vector<std::array<size_t, 3>> triangles(array.shape(0));
+  for(py::ssize_t t = 0; t < array.shape(0); ++t) {
+    for(py::ssize_t j = 0; j < 3; ++j) {
+      if(entries(t, j) < 0) {
+        throw py::value_error("expected non-negative indices");
+      }
+      triangles[t][j] = static_cast<size_t>(entries(t, j));
+    }
+  }
+  return triangles;
+}
+
+// convert a complex numpy array of shape (3,) into a complex coordinate
+AnalyticSolution::ComplexCoordinate toComplexCoordinate(const ComplexArray& array)
+{
+  if(array.ndim() != 1 || array.shape(0) != dim) {
+    throw py::value_error("expected an array of shape (3,)");
+  }
+  AnalyticSolution::ComplexCoordinate coordinate;
+  std::copy_n(array.data(), dim, coordinate.begin());
+  return coordinate;
+}
+
+// number of rows of a lead field consisting of numberOfBatches matrices with the given number of columns
+py::ssize_t numberOfRows(const std::vector<Scalar>& leadField, size_t numberOfColumns, size_t numberOfBatches = 1)
+{
+  return numberOfColumns * numberOfBatches > 0 ? leadField.size() / (numberOfColumns * numberOfBatches) : 0;
+}
+
+// convert a vector of coordinates into a numpy array of shape (N, 3)
+py::array_t<Scalar> toArray(const std::vector<CoordinateType>& coordinates)
+{
+  py::array_t<Scalar> array({static_cast<py::ssize_t>(coordinates.size()), static_cast<py::ssize_t>(dim)});
+  auto entries = array.mutable_unchecked<2>();
+  for(size_t i = 0; i < coordinates.size(); ++i) {
+    for(size_t j = 0; j < dim; ++j) {
+      entries(i, j) = coordinates[i][j];
+    }
+  }
+  return array;
+}
+
+// move a vector of real or complex scalars into a numpy array of the given shape without copying the entries
+template<class T>
+py::array_t<T> toArray(std::vector<T>&& values, std::vector<py::ssize_t> shape)
+{
+  auto* storage = new std::vector<T>(std::move(values));
+  py::capsule owner(storage, [](void* pointer) { delete static_cast<std::vector<T>*>(pointer); });
+  return py::array_t<T>(shape, storage->data(), owner);
+}
+
+// wrap a lead field view into a read only numpy array, which keeps the owner of the entries (e.g. a memory mapping) alive
+py::array_t<Scalar> toArray(const duneuro::LeadFieldView<Scalar>& view)
+{
+  auto* owner = new std::shared_ptr<const void>(view.owner());
+  py::capsule capsule(owner, [](void* pointer) { delete static_cast<std::shared_ptr<const void>*>(pointer); });
+  py::array_t<Scalar> array({static_cast<py::ssize_t>(view.rows()), static_cast<py::ssize_t>(view.columns())}, view.data(), capsule);
+  array.attr("setflags")(py::arg("write") = false);
+  return array;
+}
+
+// convert the instrumentation counters into a python dictionary
+py::dict toDict(const duneuro::InstrumentationStatistics& statistics)
+{
+  py::dict evaluations;
+  evaluations["totalField"] = statistics.evaluations[static_cast<size_t>(duneuro::InstrumentedMethod::totalField)];
+  evaluations["primaryField"] = statistics.evaluations[static_cast<size_t>(duneuro::InstrumentedMethod::primaryField)];
+  evaluations["secondaryField"] = statistics.evaluations[static_cast<size_t>(duneuro::InstrumentedMethod::secondaryField)];
+  evaluations["leadField"] = statistics.evaluations[static_cast<size_t>(duneuro::InstrumentedMethod::leadField)];
+
+  py::dict phaseTimes;
+  phaseTimes["bind"] = statistics.phaseTimes[static_cast<size_t>(duneuro::InstrumentedPhase::bind)];
+  phaseTimes["geometry"] = statistics.phaseTimes[static_cast<size_t>(duneuro::InstrumentedPhase::geometry)];
+  phaseTimes["kernel"] = statistics.phaseTimes[static_cast<size_t>(duneuro::InstrumentedPhase::kernel)];
+  phaseTimes["reduction"] = statistics.phaseTimes[static_cast<size_t>(duneuro::InstrumentedPhase::reduction)];
+  phaseTimes["transform"] = statistics.phaseTimes[static_cast<size_t>(duneuro::InstrumentedPhase::transform)];
+
+  py::dict result;
+  result["enabled"] = statistics.enabled;
+  result["evaluations"] = evaluations;
+  result["phase_times"] = phaseTimes;
+  result["near_singular_hits"] = statistics.nearSingularHits;
+  result["parallel_regions"] = statistics.parallelRegions;
+  result["parallel_wall_time"] = statistics.parallelWallTime;
+  result["thread_busy_time"] = statistics.threadBusyTime;
+  result["thread_utilization"] = statistics.threadUtilization();
+  return result;
+}
+
+///////////////////////////////////////////////////////////
+// Bindings for the point set files
+///////////////////////////////////////////////////////////
+void register_point_set_file(py::module& m) {
+  py::class_<PointSet>(m, "PointSet", "memory mapped point set file of positions and optional directions, e.g. a source space, stored as float32 or float64 arrays of x-, y- and z-coordinates")
+    .def(py::init([](const std::string& filename) { return duneuro::mapPointSetFile<Scalar>(filename); }), "map the point set file", py::arg("filename"))
+    .def("__len__", &PointSet::size)
+    .def_property_readonly("has_directions", &PointSet::hasDirections, "whether the file contains a direction per point")
+    .def("positions", [](const PointSet& points) { return toArray(points.positions()); }, "copy the positions into an (N, 3) array")
+    .def("directions", [](const PointSet& points) { return toArray(points.directions()); }, "copy the directions into an (N, 3) array")
+    ; // end definition of class
+
+  m.def("writePointSetFile", [](const std::string& filename, const CoordinateArray& positions, const py::object& directions, const std::string& precision) {
+      auto points = toCoordinates(positions);
+      auto pointDirections = directions.is_none() ? std::vector<CoordinateType>() : toCoordinates(directions.cast<CoordinateArray>());
+      if(precision == "double") {
+        duneuro::writePointSetFile<double>(filename, points, pointDirections);
+      }
+      else if(precision == "float") {
+        duneuro::writePointSetFile<float>(filename, points, pointDirections);
+      }
+      else {
+        throw py::value_error("expected the precision double or float");
+      }
+    }, "write the (N, 3) positions and optional (N, 3) directions into a point set file with float64 (double) or float32 (float) arrays", py::arg("filename"), py::arg("positions"), py::arg("directions") = py::none(), py::arg("precision") = "double");
+} // end register_point_set_file
 
 ///////////////////////////////////////////////////////////
 // Bindings for the AnalyticSolutionMEG class
@@ -32,21 +296,601 @@ using Dipole = duneuro::Dipole<Scalar, dim>;
 void register_analytic_solution_meg(py::module& m) {
   py::class_<duneuro::AnalyticSolutionMEG<Scalar>>(m, "AnalyticSolutionMEG", "class implementing the analytic solution of the MEG forward problem in multilayer sphere models")
     .def(py::init<const CoordinateType&, Scalar>(), "create analytic solver using the sphere center and the scaling factor", py::arg("sphere_center"), py::arg("scaling_factor") = 1.0)
-    .def("bind", &duneuro::AnalyticSolutionMEG<Scalar>::bind, "bind the dipole we want to solve for")
+    .def("bind", py::overload_cast<const Dipole&>(&duneuro::AnalyticSolutionMEG<Scalar>::bind), "bind the dipole we want to solve for")
+    .def("bind", [](AnalyticSolution& solver, const CoordinateType& position, const ComplexArray& moment) {
+        solver.bind(position, toComplexCoordinate(moment));
+      }, "bind a dipole with a complex moment of shape (3,), whose real part is used by the real valued methods", py::arg("position"), py::arg("moment"))
     .def("totalField", py::overload_cast<const CoordinateType&>(&duneuro::AnalyticSolutionMEG<Scalar>::totalField), "compute the total magnetic field vector at the specified position")
     .def("totalField", py::overload_cast<const CoordinateType&, const CoordinateType&>(&duneuro::AnalyticSolutionMEG<Scalar>::totalField), "compute the total magnetic field at the specified position in the specified direction")
     .def("primaryField", py::overload_cast<const CoordinateType&>(&duneuro::AnalyticSolutionMEG<Scalar>::primaryField), "compute the primary magnetic field vector at the specified position")
     .def("primaryField", py::overload_cast<const CoordinateType&, const CoordinateType&>(&duneuro::AnalyticSolutionMEG<Scalar>::primaryField), "compute the primary magnetic field at the specified position in the specified direction")
     .def("secondaryField", py::overload_cast<const CoordinateType&>(&duneuro::AnalyticSolutionMEG<Scalar>::secondaryField), "compute the secondary magnetic field vector at the specified position")
     .def("secondaryField", py::overload_cast<const CoordinateType&, const CoordinateType&>(&duneuro::AnalyticSolutionMEG<Scalar>::secondaryField), "compute the secondary magnetic field at the specified position in the specified direction")
+    .def("scalarPotential", &duneuro::AnalyticSolutionMEG<Scalar>::scalarPotential, "compute the magnetic scalar potential W outside of the conductor at the specified position, such that the total field is grad W", py::arg("position"))
+    .def("totalFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions) {
+        return toArray(solver.totalField(toCoordinates(coilPositions)));
+      }, "compute the total magnetic field vectors at the positions given as an (N, 3) array", py::arg("coil_positions"))
+    .def("totalFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions, const CoordinateArray& directions) {
+        auto fields = solver.totalField(toCoordinates(coilPositions), toCoordinates(directions));
+        py::ssize_t size = fields.size();
+        return toArray(std::move(fields), {size});
+      }, "compute the total magnetic field at the positions given as an (N, 3) array in the directions given as an (N, 3) array", py::arg("coil_positions"), py::arg("directions"))
+    .def("primaryFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions) {
+        return toArray(solver.primaryField(toCoordinates(coilPositions)));
+      }, "compute the primary magnetic field vectors at the positions given as an (N, 3) array", py::arg("coil_positions"))
+    .def("primaryFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions, const CoordinateArray& directions) {
+        auto fields = solver.primaryField(toCoordinates(coilPositions), toCoordinates(directions));
+        py::ssize_t size = fields.size();
+        return toArray(std::move(fields), {size});
+      }, "compute the primary magnetic field at the positions given as an (N, 3) array in the directions given as an (N, 3) array", py::arg("coil_positions"), py::arg("directions"))
+    .def("secondaryFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions) {
+        return toArray(solver.secondaryField(toCoordinates(coilPositions)));
+      }, "compute the secondary magnetic field vectors at the positions given as an (N, 3) array", py::arg("coil_positions"))
+    .def("secondaryFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions, const CoordinateArray& directions) {
+        auto fields = solver.secondaryField(toCoordinates(coilPositions), toCoordinates(directions));
+        py::ssize_t size = fields.size();
+        return toArray(std::move(fields), {size});
+      }, "compute the secondary magnetic field at the positions given as an (N, 3) array in the directions given as an (N, 3) array", py::arg("coil_positions"), py::arg("directions"))
+    .def("leadField", [](const AnalyticSolution& solver, const PointSet& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.leadField(dipolePositions, coils, directions, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadField, dim * dipolePositions.size());
+        return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(dim * dipolePositions.size())});
+      }, "compute the lead field of leadField for the dipole positions of a mapped PointSet, which are read from the mapping by the threads without converting the source space", py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("leadField", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.leadField(positions, coils, directions, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadField, dim * positions.size());
+        return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(dim * positions.size())});
+      }, "compute the (#coils, 3 * #dipoles) lead field of the total field for unit dipoles in x-, y- and z-direction at the given positions. The channel_transforms, a list of (#output channels, #input channels) arrays applied in order, e.g. synthetic gradiometers or SSP projectors, are applied per tile and replace #coils by the output channels of the last transform", py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("leadFieldPoses", [](const AnalyticSolution& solver, const py::array_t<Scalar, py::array::c_style | py::array::forcecast>& rotations, const CoordinateArray& translations, const CoordinateArray& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        if(rotations.ndim() != 3 || rotations.shape(1) != dim || rotations.shape(2) != dim) {
+          throw py::value_error("expected rotations of shape (P, 3, 3)");
+        }
+        auto shifts = toCoordinates(translations);
+        if(static_cast<size_t>(rotations.shape(0)) != shifts.size()) {
+          throw py::value_error("number of rotations and number of translations differ");
+        }
+        auto entries = rotations.unchecked<3>();
+        std::vector<duneuro::RigidTransform<Scalar>> poses;
+        for(size_t pose = 0; pose < shifts.size(); ++pose) {
+          duneuro::RigidTransform<Scalar>::Matrix rotation;
+          for(py::ssize_t i = 0; i < dim; ++i) {
+            for(py::ssize_t j = 0; j < dim; ++j) {
+              rotation[i][j] = entries(pose, i, j);
+            }
+          }
+          poses.emplace_back(rotation, shifts[pose]);
+        }
+        auto positions = toCoordinates(dipolePositions);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadFields;
+        {
+          py::gil_scoped_release release;
+          leadFields = solver.leadField(poses, positions, coils, directions, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadFields, dim * positions.size(), poses.size());
+        return toArray(std::move(leadFields), {static_cast<py::ssize_t>(poses.size()), rows, static_cast<py::ssize_t>(dim * positions.size())});
+      }, "compute the (#poses, #coils, 3 * #dipoles) lead fields for head poses x_device = rotation x_head + translation, given as (P, 3, 3) and (P, 3) arrays, with dipoles and sphere center in head and coils in device coordinates", py::arg("rotations"), py::arg("translations"), py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("localSphereLeadField", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, const CoordinateArray& sphereCenters, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        auto centers = toCoordinates(sphereCenters);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.localSphereLeadField(positions, coils, directions, centers, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadField, dim * positions.size());
+        return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(dim * positions.size())});
+      }, "compute the (#coils, 3 * #dipoles) lead field of leadField for a local sphere model with the sphere centers of the coils given as a (#coils, 3) array", py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("sphere_centers"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("totalFieldTimeSeries", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& dipoleMoments, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads) {
+        if(coilPositions.ndim() != 3 || coilDirections.ndim() != 3 || coilPositions.shape(0) != coilDirections.shape(0) || coilPositions.shape(1) != coilDirections.shape(1)) {
+          throw py::value_error("expected coil positions and directions of shape (T, S, 3)");
+        }
+        if(dipoleMoments.ndim() != 2 && !(dipoleMoments.ndim() == 3 && dipoleMoments.shape(0) == coilPositions.shape(0))) {
+          throw py::value_error("expected dipole moments of shape (N, 3) or (T, N, 3)");
+        }
+        auto positions = toCoordinates(dipolePositions);
+        auto moments = flattenCoordinates(dipoleMoments);
+        auto coils = flattenCoordinates(coilPositions);
+        auto directions = flattenCoordinates(coilDirections);
+        std::vector<Scalar> fields;
+        {
+          py::gil_scoped_release release;
+          fields = solver.totalFieldTimeSeries(positions, moments, coils, directions, coilPositions.shape(1), numberOfThreads);
+        }
+        return toArray(std::move(fields), {coilPositions.shape(0), coilPositions.shape(1)});
+      }, "compute the (T, S) time series of the summed total field of the dipoles at moving coils, given as (T, S, 3) arrays of positions and directions. The moments are given as an (N, 3) array, used for all samples, or as a (T, N, 3) array", py::arg("dipole_positions"), py::arg("dipole_moments"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0)
+    .def("tangentialLeadField", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.tangentialLeadField(positions, coils, directions, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadField, 2 * positions.size());
+        return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(2 * positions.size())});
+      }, "compute the (#coils, 2 * #dipoles) lead field of the total field for unit dipoles in the two directions of tangentialBasis at the given positions", py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("fixedOrientationLeadField", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& dipoleOrientations, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto orientations = toCoordinates(dipoleOrientations);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.fixedOrientationLeadField(positions, orientations, coils, directions, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadField, positions.size());
+        return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(positions.size())});
+      }, "compute the (#coils, #dipoles) lead field of the total field for dipoles at the given positions with the given (N, 3) moments, e.g. surface normals", py::arg("dipole_positions"), py::arg("dipole_orientations"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("patchLeadField", [](const AnalyticSolution& solver, const CoordinateArray& vertices, const IndexArray& triangles, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, const IndexArray& patchIndices, int quadratureOrder, Scalar refinementFactor, size_t maximumRefinementLevel, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto points = toCoordinates(vertices);
+        auto elements = toTriangles(triangles);
+        auto patches = toIndices(patchIndices);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadField;
+        size_t numberOfPatches;
+        {
+          py::gil_scoped_release release;
+          auto quadrature = duneuro::makePatchQuadrature(points, elements, patches, coils, quadratureOrder, refinementFactor, maximumRefinementLevel, numberOfThreads);
+          numberOfPatches = quadrature.numberOfPatches();
+          leadField = solver.patchLeadField(quadrature, coils, directions, numberOfThreads, transforms);
+        }
+        py::ssize_t rows = numberOfRows(leadField, numberOfPatches);
+        return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(numberOfPatches)});
+      }, "compute the (#coils, #patches) lead field of patches of the triangles (T, 3) of vertices (V, 3) with a uniform normal current density of unit strength, where triangle t belongs to patch patch_indices[t], or is a patch of its own if patch_indices is empty. Every triangle is integrated with a quadrature rule of the given order and split into four up to maximum_refinement_level times while it is closer to a coil than refinement_factor times its longest edge", py::arg("vertices"), py::arg("triangles"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("patch_indices") = IndexArray(0), py::arg("quadrature_order") = 2, py::arg("refinement_factor") = 2.0, py::arg("maximum_refinement_level") = 4, py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("complexTotalField", [](AnalyticSolution& solver, const CoordinateType& coilPosition) {
+        auto field = solver.complexTotalField(coilPosition);
+        return toArray(std::vector<std::complex<Scalar>>(field.begin(), field.end()), {static_cast<py::ssize_t>(dim)});
+      }, "compute the complex total magnetic field vector of the bound complex moment at the specified position", py::arg("coil_position"))
+    .def("complexTotalFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions) {
+        auto fields = solver.complexTotalField(toCoordinates(coilPositions));
+        std::vector<std::complex<Scalar>> entries(dim * fields.size());
+        for(size_t i = 0; i < fields.size(); ++i) {
+          std::copy(fields[i].begin(), fields[i].end(), entries.begin() + dim * i);
+        }
+        return toArray(std::move(entries), {static_cast<py::ssize_t>(fields.size()), static_cast<py::ssize_t>(dim)});
+      }, "compute the (N, 3) complex total field vectors of the bound complex moment at the (N, 3) coil positions", py::arg("coil_positions"))
+    .def("complexTotalFieldBatch", [](AnalyticSolution& solver, const CoordinateArray& coilPositions, const CoordinateArray& directions) {
+        auto fields = solver.complexTotalField(toCoordinates(coilPositions), toCoordinates(directions));
+        py::ssize_t size = static_cast<py::ssize_t>(fields.size());
+        return toArray(std::move(fields), {size});
+      }, "compute the (N,) complex total fields of the bound complex moment at the (N, 3) coil positions in the (N, 3) directions", py::arg("coil_positions"), py::arg("directions"))
+    .def("totalFieldMultiAxis", [](AnalyticSolution& solver, const CoordinateArray& sensorPositions, const CoordinateArray& sensorAxes) {
+        auto sensors = toSensors(sensorPositions, sensorAxes);
+        return toArray(solver.totalField(sensors), {sensorAxes.shape(0), sensorAxes.shape(1)});
+      }, "compute the (S, k) total magnetic fields of the bound dipole at multi-axis sensors, given as (S, 3) positions and (S, k, 3) axes", py::arg("sensor_positions"), py::arg("sensor_axes"))
+    .def("leadFieldMultiAxis", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& sensorPositions, const CoordinateArray& sensorAxes, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto sensors = toSensors(sensorPositions, sensorAxes);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.leadField(positions, sensors, numberOfThreads, transforms);
+        }
+        if(!transforms.empty()) {
+          py::ssize_t rows = numberOfRows(leadField, dim * positions.size());
+          return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(dim * positions.size())});
+        }
+        return toArray(std::move(leadField), {sensorAxes.shape(0), sensorAxes.shape(1), static_cast<py::ssize_t>(dim * positions.size())});
+      }, "compute the (S, k, 3 * #dipoles) lead field of leadField for multi-axis sensors, given as (S, 3) positions and (S, k, 3) axes, evaluating the geometry once per sensor for all axes. With channel_transforms the result has shape (#output channels, 3 * #dipoles)", py::arg("dipole_positions"), py::arg("sensor_positions"), py::arg("sensor_axes"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("tangentialLeadFieldMultiAxis", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& sensorPositions, const CoordinateArray& sensorAxes, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto sensors = toSensors(sensorPositions, sensorAxes);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.tangentialLeadField(positions, sensors, numberOfThreads, transforms);
+        }
+        if(!transforms.empty()) {
+          py::ssize_t rows = numberOfRows(leadField, 2 * positions.size());
+          return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(2 * positions.size())});
+        }
+        return toArray(std::move(leadField), {sensorAxes.shape(0), sensorAxes.shape(1), static_cast<py::ssize_t>(2 * positions.size())});
+      }, "compute the (S, k, 2 * #dipoles) lead field of tangentialLeadField for multi-axis sensors, given as (S, 3) positions and (S, k, 3) axes", py::arg("dipole_positions"), py::arg("sensor_positions"), py::arg("sensor_axes"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("fixedOrientationLeadFieldMultiAxis", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& dipoleOrientations, const CoordinateArray& sensorPositions, const CoordinateArray& sensorAxes, size_t numberOfThreads, const py::list& channelTransforms) {
+        auto transforms = toChannelTransforms(channelTransforms);
+        auto positions = toCoordinates(dipolePositions);
+        auto orientations = toCoordinates(dipoleOrientations);
+        auto sensors = toSensors(sensorPositions, sensorAxes);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.fixedOrientationLeadField(positions, orientations, sensors, numberOfThreads, transforms);
+        }
+        if(!transforms.empty()) {
+          py::ssize_t rows = numberOfRows(leadField, positions.size());
+          return toArray(std::move(leadField), {rows, static_cast<py::ssize_t>(positions.size())});
+        }
+        return toArray(std::move(leadField), {sensorAxes.shape(0), sensorAxes.shape(1), static_cast<py::ssize_t>(positions.size())});
+      }, "compute the (S, k, #dipoles) lead field of fixedOrientationLeadField for multi-axis sensors, given as (S, 3) positions and (S, k, 3) axes", py::arg("dipole_positions"), py::arg("dipole_orientations"), py::arg("sensor_positions"), py::arg("sensor_axes"), py::arg("number_of_threads") = 0, py::arg("channel_transforms") = py::list())
+    .def("tangentialBasis", [](const AnalyticSolution& solver, const CoordinateArray& dipolePositions) {
+        auto positions = toCoordinates(dipolePositions);
+        std::vector<Scalar> bases(2 * dim * positions.size());
+        for(size_t i = 0; i < positions.size(); ++i) {
+          auto basis = solver.tangentialBasis(positions[i]);
+          std::copy(basis[0].begin(), basis[0].end(), bases.begin() + 2 * dim * i);
+          std::copy(basis[1].begin(), basis[1].end(), bases.begin() + 2 * dim * i + dim);
+        }
+        return toArray(std::move(bases), {static_cast<py::ssize_t>(positions.size()), 2, static_cast<py::ssize_t>(dim)});
+      }, "return the (#dipoles, 2, 3) orthonormal tangential directions used by tangentialLeadField", py::arg("dipole_positions"))
+    .def("stats", [](const AnalyticSolution& solver) { return toDict(solver.statistics()); }, "return the instrumentation counters collected since construction or the last reset (only filled if the module was built with DUNEURO_ANALYTIC_SOLUTION_INSTRUMENTATION)")
+    .def("resetStats", &duneuro::AnalyticSolutionMEG<Scalar>::resetStatistics, "reset the instrumentation counters")
     ; // end definition of class
 } // end register_analytic_solution_meg
 
+///////////////////////////////////////////////////////////
+// Bindings for the AnalyticSolutionEEG class
+///////////////////////////////////////////////////////////
+void register_analytic_solution_eeg(py::module& m) {
+  using AnalyticSolutionEEG = duneuro::AnalyticSolutionEEG<Scalar>;
+  py::class_<AnalyticSolutionEEG>(m, "AnalyticSolutionEEG", "class implementing the analytic solution of the EEG forward problem in multilayer sphere models")
+    .def(py::init([](const CoordinateType& sphereCenter, const py::array_t<Scalar, py::array::c_style | py::array::forcecast>& radii, const py::array_t<Scalar, py::array::c_style | py::array::forcecast>& conductivities, Scalar tolerance, size_t maximumOrder) {
+        return AnalyticSolutionEEG(sphereCenter, toVector(radii), toVector(conductivities), tolerance, maximumOrder);
+      }), "create analytic solver using the sphere center and the radii and conductivities of the layers from the innermost to the outermost. The series is truncated once the remaining terms are below tolerance relative to the leading term, the evaluation raises an error if this needs more than maximum_order terms", py::arg("sphere_center"), py::arg("radii"), py::arg("conductivities"), py::arg("tolerance") = 1e-10, py::arg("maximum_order") = 1000)
+    .def("bind", &AnalyticSolutionEEG::bind, "bind the dipole we want to solve for, which has to lie in the innermost layer")
+    .def("potential", py::overload_cast<const CoordinateType&>(&AnalyticSolutionEEG::potential, py::const_), "compute the potential with respect to infinity at the electrode, projected onto the outer sphere", py::arg("electrode_position"))
+    .def("potentialBatch", [](const AnalyticSolutionEEG& solver, const CoordinateArray& electrodePositions) {
+        auto potentials = solver.potential(toCoordinates(electrodePositions));
+        py::ssize_t size = potentials.size();
+        return toArray(std::move(potentials), {size});
+      }, "compute the potentials at the electrodes given as an (N, 3) array", py::arg("electrode_positions"))
+    .def("leadField", [](const AnalyticSolutionEEG& solver, const CoordinateArray& dipolePositions, const CoordinateArray& electrodePositions, size_t numberOfThreads) {
+        auto positions = toCoordinates(dipolePositions);
+        auto electrodes = toCoordinates(electrodePositions);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = solver.leadField(positions, electrodes, numberOfThreads);
+        }
+        return toArray(std::move(leadField), {static_cast<py::ssize_t>(electrodes.size()), static_cast<py::ssize_t>(dim * positions.size())});
+      }, "compute the (#electrodes, 3 * #dipoles) lead field of the potential for unit dipoles in x-, y- and z-direction at the given positions", py::arg("dipole_positions"), py::arg("electrode_positions"), py::arg("number_of_threads") = 0)
+    .def("numberOfTerms", &AnalyticSolutionEEG::numberOfTerms, "number of explicitly summed terms of the series for a dipole at the given position, raises an error if the tolerance is not reached within maximum_order terms", py::arg("dipole_position"))
+    ; // end definition of class
+} // end register_analytic_solution_eeg
+
+///////////////////////////////////////////////////////////
+// Bindings for the BergApproximationEEG class
+///////////////////////////////////////////////////////////
+void register_berg_approximation(py::module& m) {
+  using Berg = duneuro::BergApproximationEEG<Scalar>;
+  py::class_<Berg>(m, "BergApproximationEEG", "fast approximation of AnalyticSolutionEEG by the closed form potentials of a few dipoles in a homogeneous sphere, with Berg parameters fitted once per model")
+    .def(py::init<const duneuro::AnalyticSolutionEEG<Scalar>&, size_t, size_t>(), "fit the eccentricities and magnitudes of number_of_dipoles Berg dipoles to the series coefficients of solver up to fit_order", py::arg("solver"), py::arg("number_of_dipoles") = 3, py::arg("fit_order") = 200)
+    .def("bind", &Berg::bind, "bind the dipole we want to solve for")
+    .def("potential", py::overload_cast<const CoordinateType&>(&Berg::potential, py::const_), "approximate the potential at the electrode, projected onto the outer sphere", py::arg("electrode_position"))
+    .def("potentialBatch", [](const Berg& berg, const CoordinateArray& electrodePositions) {
+        auto potentials = berg.potential(toCoordinates(electrodePositions));
+        py::ssize_t size = potentials.size();
+        return toArray(std::move(potentials), {size});
+      }, "approximate the potentials at the electrodes given as an (N, 3) array", py::arg("electrode_positions"))
+    .def("leadField", [](const Berg& berg, const CoordinateArray& dipolePositions, const CoordinateArray& electrodePositions, size_t numberOfThreads) {
+        auto positions = toCoordinates(dipolePositions);
+        auto electrodes = toCoordinates(electrodePositions);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = berg.leadField(positions, electrodes, numberOfThreads);
+        }
+        return toArray(std::move(leadField), {static_cast<py::ssize_t>(electrodes.size()), static_cast<py::ssize_t>(dim * positions.size())});
+      }, "approximate the (#electrodes, 3 * #dipoles) lead field of AnalyticSolutionEEG.leadField", py::arg("dipole_positions"), py::arg("electrode_positions"), py::arg("number_of_threads") = 0)
+    .def("approximationError", &Berg::approximationError, "largest relative error of the potentials of radial and tangential test dipoles at eccentricities up to 0.98 of the innermost radius")
+    .def("eccentricities", [](const Berg& berg) {
+        std::vector<Scalar> values = berg.eccentricities();
+        py::ssize_t size = values.size();
+        return toArray(std::move(values), {size});
+      }, "fitted eccentricities mu_j of the Berg dipoles")
+    .def("magnitudes", [](const Berg& berg) {
+        std::vector<Scalar> values = berg.magnitudes();
+        py::ssize_t size = values.size();
+        return toArray(std::move(values), {size});
+      }, "fitted magnitudes lambda_j of the Berg dipoles")
+    ; // end definition of class
+} // end register_berg_approximation
+
+///////////////////////////////////////////////////////////
+// Bindings for the joint EEG and MEG lead field
+///////////////////////////////////////////////////////////
+void register_joint_leadfield(py::module& m) {
+  m.def("jointLeadField", [](const duneuro::AnalyticSolutionEEG<Scalar>& eeg, const AnalyticSolution& meg, const CoordinateArray& dipolePositions, const CoordinateArray& electrodePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads) {
+      auto positions = toCoordinates(dipolePositions);
+      auto electrodes = toCoordinates(electrodePositions);
+      auto coils = toCoordinates(coilPositions);
+      auto directions = toCoordinates(coilDirections);
+      std::vector<Scalar> leadField;
+      {
+        py::gil_scoped_release release;
+        leadField = duneuro::jointLeadField(eeg, meg, positions, electrodes, coils, directions, numberOfThreads);
+      }
+      return toArray(std::move(leadField), {static_cast<py::ssize_t>(electrodes.size() + coils.size()), static_cast<py::ssize_t>(dim * positions.size())});
+    }, "compute the (#electrodes + #coils, 3 * #dipoles) lead field with the EEG rows of eeg.leadField followed by the MEG rows of meg.leadField in a single pass over the source space", py::arg("eeg"), py::arg("meg"), py::arg("dipole_positions"), py::arg("electrode_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0);
+} // end register_joint_leadfield
+
+///////////////////////////////////////////////////////////
+// Bindings for the sphere fitting
+///////////////////////////////////////////////////////////
+void register_sphere_fit(py::module& m) {
+  m.def("fitSphere", [](const CoordinateArray& points, Scalar trimFraction, size_t numberOfThreads) {
+      auto coordinates = toCoordinates(points);
+      duneuro::SphereFit<Scalar> fit;
+      {
+        py::gil_scoped_release release;
+        fit = duneuro::fitSphere(coordinates, trimFraction, numberOfThreads);
+      }
+      py::dict result;
+      result["center"] = toArray(std::vector<Scalar>(fit.center.begin(), fit.center.end()), {static_cast<py::ssize_t>(dim)});
+      result["radius"] = fit.radius;
+      result["rms_residual"] = fit.rmsResidual;
+      result["number_of_inliers"] = fit.numberOfInliers;
+      return result;
+    }, "fit a sphere to the (#points, 3) array points, discarding the trim_fraction of points farthest from the sphere, and return a dictionary with center, radius, rms_residual and number_of_inliers", py::arg("points"), py::arg("trim_fraction") = 0.0, py::arg("number_of_threads") = 0);
+
+  m.def("fitLocalSpheres", [](const CoordinateArray& points, const CoordinateArray& sensorPositions, Scalar neighbourhoodRadius, Scalar trimFraction, size_t numberOfThreads) {
+      auto coordinates = toCoordinates(points);
+      auto sensors = toCoordinates(sensorPositions);
+      std::vector<duneuro::SphereFit<Scalar>> fits;
+      {
+        py::gil_scoped_release release;
+        fits = duneuro::fitLocalSpheres(coordinates, sensors, neighbourhoodRadius, trimFraction, numberOfThreads);
+      }
+      std::vector<CoordinateType> centers(fits.size());
+      std::vector<Scalar> radii(fits.size());
+      for(size_t i = 0; i < fits.size(); ++i) {
+        centers[i] = fits[i].center;
+        radii[i] = fits[i].radius;
+      }
+      py::ssize_t size = static_cast<py::ssize_t>(radii.size());
+      return py::make_tuple(toArray(centers), toArray(std::move(radii), {size}));
+    }, "fit one sphere per sensor to the points within neighbourhood_radius of the sensor and return the (#sensors, 3) centers and the (#sensors,) radii, e.g. as the sphere centers of localSphereLeadField", py::arg("points"), py::arg("sensor_positions"), py::arg("neighbourhood_radius"), py::arg("trim_fraction") = 0.0, py::arg("number_of_threads") = 0);
+} // end register_sphere_fit
+
+///////////////////////////////////////////////////////////
+// Bindings for the LeadFieldCache class
+///////////////////////////////////////////////////////////
+void register_leadfield_cache(py::module& m) {
+  py::class_<duneuro::LeadFieldCache>(m, "LeadFieldCache", "persistent on-disk cache of analytic lead fields, keyed by a hash of sphere center, scaling factor, coils and dipole positions")
+    .def(py::init<const std::string&, uint64_t>(), "create a cache in the given directory, evicting the least recently used entries if it grows beyond maximum_size bytes (0 means no limit)", py::arg("directory"), py::arg("maximum_size") = 0)
+    .def("leadField", [](duneuro::LeadFieldCache& cache, const AnalyticSolution& solver, const CoordinateArray& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads) {
+        auto positions = toCoordinates(dipolePositions);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        py::gil_scoped_release release;
+        auto view = cache.leadField(solver, positions, coils, directions, numberOfThreads);
+        py::gil_scoped_acquire acquire;
+        return toArray(view);
+      }, "return the lead field of solver.leadField from the cache, computing and storing it on a miss. Cached lead fields are returned as read only arrays mapping the cache file", py::arg("solver"), py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0)
+    .def("clear", &duneuro::LeadFieldCache::clear, "remove all entries of the cache")
+    .def("size", &duneuro::LeadFieldCache::size, "total size of the cache entries in bytes")
+    .def_property_readonly("hits", &duneuro::LeadFieldCache::hits, "number of lead fields found in the cache")
+    .def_property_readonly("misses", &duneuro::LeadFieldCache::misses, "number of lead fields computed because they were not found in the cache")
+    ; // end definition of class
+
+  m.def("mapLeadFieldFile", [](const std::string& filename) {
+      return toArray(duneuro::mapLeadFieldFile<Scalar>(filename));
+    }, "map a float64 lead field file, e.g. written by compute-leadfield, as a read only array", py::arg("filename"));
+} // end register_leadfield_cache
+
+///////////////////////////////////////////////////////////
+// Bindings for the LeadFieldColumnCache class
+///////////////////////////////////////////////////////////
+void register_leadfield_column_cache(py::module& m) {
+  using ColumnCache = duneuro::LeadFieldColumnCache<Scalar>;
+  py::class_<ColumnCache>(m, "LeadFieldColumnCache", "least recently used in-memory cache of the (#coils, 3) lead fields of single dipole positions, for iterative inverse methods")
+    .def(py::init([](const AnalyticSolution& solver, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t memoryBudget, Scalar tolerance) {
+        return new ColumnCache(solver, toCoordinates(coilPositions), toCoordinates(coilDirections), memoryBudget, tolerance);
+      }), "create a cache for the given solver and coils, using at most memory_budget bytes. Positions are rounded to a grid of spacing tolerance, 0 meaning only identical positions share an entry", py::arg("solver"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("memory_budget"), py::arg("tolerance") = 0.0)
+    .def("leadField", [](ColumnCache& cache, const CoordinateType& position) {
+        auto columns = cache.leadField(position);
+        // the array keeps the shared entry alive, even if it is evicted from the cache
+        auto* owner = new ColumnCache::Columns(columns);
+        py::capsule capsule(owner, [](void* pointer) { delete static_cast<ColumnCache::Columns*>(pointer); });
+        py::array_t<Scalar> array({static_cast<py::ssize_t>(cache.numberOfCoils()), static_cast<py::ssize_t>(dim)}, columns->data(), capsule);
+        array.attr("setflags")(py::arg("write") = false);
+        return array;
+      }, "return the read only (#coils, 3) lead field at the given position, computing it on a miss", py::arg("dipole_position"))
+    .def("stats", [](const ColumnCache& cache) {
+        auto statistics = cache.statistics();
+        py::dict result;
+        result["hits"] = statistics.hits;
+        result["misses"] = statistics.misses;
+        result["evictions"] = statistics.evictions;
+        result["entries"] = statistics.entries;
+        result["memory_usage"] = statistics.memoryUsage;
+        return result;
+      }, "return hits, misses, evictions, number of entries and memory usage in bytes")
+    .def("resetStats", &ColumnCache::resetStatistics, "reset hits, misses and evictions")
+    .def("clear", &ColumnCache::clear, "remove all entries")
+    ; // end definition of class
+} // end register_leadfield_column_cache
+
+///////////////////////////////////////////////////////////
+// Bindings for the TabulatedAnalyticSolutionMEG class
+///////////////////////////////////////////////////////////
+void register_lookup_table(py::module& m) {
+  using Tabulated = duneuro::TabulatedAnalyticSolutionMEG<Scalar>;
+  py::class_<Tabulated>(m, "TabulatedAnalyticSolutionMEG", "approximate lead fields for coils on a sphere of fixed radius, interpolated from a table of the invariants of the Sarvas formula")
+    .def(py::init<const AnalyticSolution&, Scalar, Scalar, Scalar, size_t>(), "tabulate the invariants of solver for coils at distance sensor_radius and dipoles at distance at most maximum_dipole_radius from the sphere center, refining the table until the estimated relative interpolation error is below tolerance", py::arg("solver"), py::arg("sensor_radius"), py::arg("maximum_dipole_radius"), py::arg("tolerance") = 1e-6, py::arg("maximum_table_size") = size_t(1) << 22)
+    .def("leadField", [](const Tabulated& table, const CoordinateArray& dipolePositions, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections, size_t numberOfThreads) {
+        auto positions = toCoordinates(dipolePositions);
+        auto coils = toCoordinates(coilPositions);
+        auto directions = toCoordinates(coilDirections);
+        std::vector<Scalar> leadField;
+        {
+          py::gil_scoped_release release;
+          leadField = table.leadField(positions, coils, directions, numberOfThreads);
+        }
+        return toArray(std::move(leadField), {static_cast<py::ssize_t>(coils.size()), static_cast<py::ssize_t>(dim * positions.size())});
+      }, "approximate the (#coils, 3 * #dipoles) lead field of AnalyticSolutionMEG.leadField", py::arg("dipole_positions"), py::arg("coil_positions"), py::arg("coil_directions"), py::arg("number_of_threads") = 0)
+    .def("errorEstimate", &Tabulated::errorEstimate, "largest relative interpolation error found at the midpoints of the grid cells")
+    .def("radiusPoints", &Tabulated::radiusPoints, "number of grid points in radius direction")
+    .def("anglePoints", &Tabulated::anglePoints, "number of grid points in angle direction")
+    ; // end definition of class
+} // end register_lookup_table
+
+///////////////////////////////////////////////////////////
+// Bindings for the multipole expansion and the SSS basis
+///////////////////////////////////////////////////////////
+void register_multipole_expansion(py::module& m) {
+  using Expansion = duneuro::MultipoleExpansionMEG<Scalar>;
+  py::class_<Expansion>(m, "MultipoleExpansionMEG", "truncated multipole expansion of the total field of a set of dipoles outside of the conductor")
+    .def(py::init<const AnalyticSolution&, size_t, Scalar>(), "create an empty expansion of the given order for the sphere model of solver, sampling the scalar potential on the sphere of the given radius, which has to contain all dipoles", py::arg("solver"), py::arg("order"), py::arg("radius"))
+    .def("addDipoles", [](Expansion& expansion, const CoordinateArray& positions, const CoordinateArray& moments, size_t numberOfThreads) {
+        auto dipoles = toDipoles(positions, moments);
+        py::gil_scoped_release release;
+        expansion.addDipoles(dipoles, numberOfThreads);
+      }, "add the dipoles given by (N, 3) arrays of positions and moments to the expansion", py::arg("positions"), py::arg("moments"), py::arg("number_of_threads") = 0)
+    .def("addDipole", &Expansion::addDipole, "add a single dipole to the expansion", py::arg("dipole"))
+    .def("addBoundDipole", &Expansion::addBoundDipole, "add the dipole bound to solver to the expansion", py::arg("solver"))
+    .def("clear", &Expansion::clear, "remove all dipoles from the expansion")
+    .def("coefficients", [](const Expansion& expansion) {
+        std::vector<Scalar> coefficients = expansion.coefficients();
+        py::ssize_t size = coefficients.size();
+        return toArray(std::move(coefficients), {size});
+      }, "return the coefficients of the expansion, matching the inner columns of sssBasis")
+    .def("totalField", py::overload_cast<const CoordinateType&>(&Expansion::totalField, py::const_), "evaluate the total magnetic field vector at the specified position", py::arg("position"))
+    .def("totalFieldBatch", [](const Expansion& expansion, const CoordinateArray& coilPositions, const CoordinateArray& directions, size_t numberOfThreads) {
+        auto coils = toCoordinates(coilPositions);
+        auto coilDirections = toCoordinates(directions);
+        std::vector<Scalar> fields;
+        {
+          py::gil_scoped_release release;
+          fields = expansion.totalField(coils, coilDirections, numberOfThreads);
+        }
+        py::ssize_t size = fields.size();
+        return toArray(std::move(fields), {size});
+      }, "evaluate the total magnetic field at the positions given as an (N, 3) array in the directions given as an (N, 3) array", py::arg("coil_positions"), py::arg("directions"), py::arg("number_of_threads") = 0)
+    .def_property_readonly("order", &Expansion::order)
+    .def_property_readonly("radius", &Expansion::radius)
+    ; // end definition of class
+
+  m.def("sssBasis", [](const CoordinateType& center, size_t innerOrder, size_t outerOrder, const CoordinateArray& coilPositions, const CoordinateArray& coilDirections) {
+      auto coils = toCoordinates(coilPositions);
+      auto basis = duneuro::signalSpaceSeparationBasis(center, innerOrder, outerOrder, coils, toCoordinates(coilDirections));
+      py::ssize_t columns = duneuro::numberOfMultipoleCoefficients(innerOrder) + duneuro::numberOfMultipoleCoefficients(outerOrder);
+      return toArray(std::move(basis), {static_cast<py::ssize_t>(coils.size()), columns});
+    }, "compute the (#coils, L_in (L_in + 2) + L_out (L_out + 2)) signal space separation basis around center, whose first columns span the fields of sources inside and whose last columns span the fields of sources outside of the sensor array", py::arg("center"), py::arg("inner_order"), py::arg("outer_order"), py::arg("coil_positions"), py::arg("coil_directions"));
+} // end register_multipole_expansion
+
+///////////////////////////////////////////////////////////
+// Bindings for the HierarchicalEvaluatorMEG class
+///////////////////////////////////////////////////////////
+void register_hierarchical_evaluator(py::module& m) {
+  using Evaluator = duneuro::HierarchicalEvaluatorMEG<Scalar>;
+  py::class_<Evaluator>(m, "HierarchicalEvaluatorMEG", "octree based evaluation of the summed total field of a large number of dipoles")
+    .def(py::init([](const AnalyticSolution& solver, const CoordinateArray& positions, const CoordinateArray& moments, size_t order, Scalar openingAngle, size_t leafSize, size_t numberOfThreads) {
+        auto dipoles = toDipoles(positions, moments);
+        py::gil_scoped_release release;
+        return new Evaluator(solver, dipoles, order, openingAngle, leafSize, numberOfThreads);
+      }), "build the octree over the dipoles given by (N, 3) arrays of positions and moments. Boxes seen under a ratio of half diagonal and distance below opening_angle are replaced by order^3 equivalent dipoles", py::arg("solver"), py::arg("positions"), py::arg("moments"), py::arg("order") = 4, py::arg("opening_angle") = 0.5, py::arg("leaf_size") = 128, py::arg("number_of_threads") = 0)
+    .def("totalField", py::overload_cast<const CoordinateType&, const CoordinateType&>(&Evaluator::totalField, py::const_), "compute the total magnetic field of all dipoles at the specified position in the specified direction", py::arg("position"), py::arg("direction"))
+    .def("totalFieldBatch", [](const Evaluator& evaluator, const CoordinateArray& coilPositions, const CoordinateArray& directions, size_t numberOfThreads) {
+        auto coils = toCoordinates(coilPositions);
+        auto coilDirections = toCoordinates(directions);
+        std::vector<Scalar> fields;
+        {
+          py::gil_scoped_release release;
+          fields = evaluator.totalField(coils, coilDirections, numberOfThreads);
+        }
+        py::ssize_t size = fields.size();
+        return toArray(std::move(fields), {size});
+      }, "compute the total magnetic field of all dipoles at the positions given as an (N, 3) array in the directions given as an (N, 3) array", py::arg("coil_positions"), py::arg("directions"), py::arg("number_of_threads") = 0)
+    .def_property_readonly("number_of_dipoles", &Evaluator::numberOfDipoles)
+    .def_property_readonly("number_of_nodes", &Evaluator::numberOfNodes)
+    ; // end definition of class
+} // end register_hierarchical_evaluator
+
+///////////////////////////////////////////////////////////
+// Bindings for the error measures
+///////////////////////////////////////////////////////////
+void register_error_measures(py::module& m) {
+  m.def("errorMeasures", [](const py::array_t<Scalar, py::array::c_style | py::array::forcecast>& analytic, const py::array_t<Scalar, py::array::c_style | py::array::forcecast>& numerical, size_t numberOfThreads) {
+      if(analytic.ndim() < 1 || analytic.ndim() > 2 || analytic.ndim() != numerical.ndim()) {
+        throw py::value_error("expected two vectors or two matrices");
+      }
+      for(py::ssize_t i = 0; i < analytic.ndim(); ++i) {
+        if(analytic.shape(i) != numerical.shape(i)) {
+          throw py::value_error("analytic and numerical solution differ in shape");
+        }
+      }
+      // a vector is treated as a matrix with a single row
+      size_t rows = analytic.ndim() == 2 ? analytic.shape(0) : 1;
+      size_t columns = analytic.shape(analytic.ndim() - 1);
+      duneuro::ErrorMeasures<Scalar> measures;
+      {
+        py::gil_scoped_release release;
+        measures = duneuro::errorMeasures(analytic.data(), numerical.data(), rows, columns, numberOfThreads);
+      }
+      py::dict result;
+      if(analytic.ndim() == 1) {
+        result["rdm"] = measures.rdm[0];
+        result["mag"] = measures.mag[0];
+        result["lnmag"] = measures.lnMag[0];
+        result["relative_error"] = measures.relativeError[0];
+      }
+      else {
+        py::ssize_t size = rows;
+        result["rdm"] = toArray(std::move(measures.rdm), {size});
+        result["mag"] = toArray(std::move(measures.mag), {size});
+        result["lnmag"] = toArray(std::move(measures.lnMag), {size});
+        result["relative_error"] = toArray(std::move(measures.relativeError), {size});
+      }
+      return result;
+    }, "compute RDM, MAG = ||numerical|| / ||analytic||, lnMAG and the relative error ||numerical - analytic|| / ||analytic|| for every row of the analytic and numerical matrices (e.g. one row per dipole), or for two vectors. If both rows vanish, RDM = 0, MAG = 1 and lnMAG = relative error = 0. If only the analytic row vanishes, RDM is nan and MAG, lnMAG and the relative error are inf. If only the numerical row vanishes, RDM is nan, MAG = 0, lnMAG = -inf and the relative error is 1", py::arg("analytic"), py::arg("numerical"), py::arg("number_of_threads") = 0);
+} // end register_error_measures
+
+///////////////////////////////////////////////////////////
+// Bindings for the Chrome trace recorder
+///////////////////////////////////////////////////////////
+void register_tracing(py::module& m) {
+  m.def("tracingAvailable", []() { return duneuro::TraceRecorder::available(); }, "check if the module was built with DUNEURO_ANALYTIC_SOLUTION_TRACING");
+  m.def("startTrace", []() { duneuro::TraceRecorder::instance().start(); }, "discard previously recorded spans and start recording spans of the multi-threaded methods");
+  m.def("stopTrace", []() { duneuro::TraceRecorder::instance().stop(); }, "stop recording spans");
+  m.def("writeTrace", [](const std::string& filename) { duneuro::TraceRecorder::instance().write(filename); }, "write the recorded spans as Chrome trace JSON file, viewable in chrome://tracing or Perfetto", py::arg("filename"));
+} // end register_tracing
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 // Create bindings
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 PYBIND11_MODULE(duneuroAnalyticSolutionPy, m) {
+  register_point_set_file(m);
   register_analytic_solution_meg(m);
+  register_analytic_solution_eeg(m);
+  register_berg_approximation(m);
+  register_joint_leadfield(m);
+  register_sphere_fit(m);
+  register_error_measures(m);
+  register_leadfield_cache(m);
+  register_leadfield_column_cache(m);
+  register_lookup_table(m);
+  register_multipole_expansion(m);
+  register_hierarchical_evaluator(m);
+  register_tracing(m);
 }